@@ -0,0 +1,328 @@
+/* ==========================================================================
+ * DFS_ENGINE.H — Iterative DFS Engine Body (instantiated per mark count)
+ * ==========================================================================
+ *
+ * Template for the explicit-stack engine described in solver.c. Each
+ * inclusion generates one static copy of
+ *
+ *     dfs_frame_range, dfs_frame_enter, dfs_stack_tighten, dfs_stack_run
+ *
+ * with DFS_SUFFIX appended to the names. Define before including:
+ *
+ *   DFS_KERNEL_N     0: generic body, n is read from the stack.
+ *                    8..MAX_MARKS: n is a compile-time constant; distances
+ *                    and the duplicate test run at fixed width n-1 with the
+ *                    loop fully unrolled (dfs_kernels.c).
+ *   DFS_SUFFIX       Name suffix of the generated functions.
+ *   DFS_RUN_LINKAGE  Optional storage class of dfs_stack_run (default static).
+ *   DFS_DUP8         Generic body only, optional: the 8-distance duplicate
+ *                    test (bs, dist8, words) used from depth 8 on; without
+ *                    it the body tests every distance with a scalar load.
+ *                    Each backend gets its own instance, so the hot loop
+ *                    holds no backend dispatch (solver.c).
+ *
+ * The includer provides set_bit, clr_bit and test_bit_scalar. With GOLOMB_STATS the
+ * body also feeds the per-thread node and prune counters of stats.c. All parameters are
+ * #undef'd at the end, so the header can be included again right away.
+ * ========================================================================== */
+
+#ifndef DFS_KERNEL_N
+#error "define DFS_KERNEL_N before including dfs_engine.h"
+#endif
+#ifndef DFS_RUN_LINKAGE
+#define DFS_RUN_LINKAGE static
+#endif
+
+#define DFS_CAT_(a, b) a##b
+#define DFS_CAT(a, b)  DFS_CAT_(a, b)
+#define DFS_FN(name)   DFS_CAT(name, DFS_SUFFIX)
+
+#if DFS_KERNEL_N
+#define DFS_NMARKS(st) DFS_KERNEL_N
+#else
+#define DFS_NMARKS(st) ((st)->n)
+#endif
+
+/* Candidate range [*lo, *hi] of frame d (marks pos[0..d-1] placed) for the
+ * current target_len; *lo on entry is the lowest candidate still wanted.
+ * Returns false if the range is empty. *cut (may be NULL) receives the
+ * number of candidates the LUT bounds removed (stats.c). */
+static inline bool DFS_FN(dfs_frame_range)(const dfs_stack_t *st, int d, int *lo, int *hi,
+                                           int *cut)
+{
+    const dfs_frame_t *f = &st->frame[d];
+    const int n = DFS_NMARKS(st);
+    const int target_len = st->target_len;
+    int last = st->pos[d - 1];
+
+    /* Lower bound: even with minimum gaps of 1, can we still reach target_len? */
+    if (last + (n - d) > target_len)
+        return false;
+
+    /* Upper bound for next mark: must leave room for (n-d-1) more marks. */
+    int max_next = target_len - (n - d - 1);
+    if (d == 1)
+    {
+        int limit = target_len / 2; /* Symmetry break: second mark <= L/2 */
+        if (limit < last + 1)
+            limit = last + 1;
+        if (max_next > limit)
+            max_next = limit;
+    }
+    /* The final mark has exactly one legal position (any position up to
+     * the bound in branch-and-bound mode). */
+    int l = (d == n - 1 && !st->best) ? target_len : last + 1;
+    if (l < *lo)
+        l = *lo;
+    int span = max_next - l + 1;
+    /* Sub-ruler bounds from the LUT (bounds.c). */
+    if (!bounds_next_range(d, n, target_len, st->pos, &l, &max_next) ||
+        !bounds_gap_sum_range(last, target_len, f->gap_sum, f->gap_thr, &l, &max_next))
+    {
+        if (cut && span > 0)
+            *cut = span;
+        return false;
+    }
+    if (cut && span > 0)
+        *cut = span - (max_next - l + 1);
+    *lo = l;
+    *hi = max_next;
+    return true;
+}
+
+/* Set up frame d (marks pos[0..d-1] placed). */
+static inline void DFS_FN(dfs_frame_enter)(dfs_stack_t *st, int d)
+{
+    dfs_frame_t *f = &st->frame[d];
+    int lo = 0;
+    int hi;
+#ifdef GOLOMB_STATS
+    int clipped = 0;
+    bool ok = DFS_FN(dfs_frame_range)(st, d, &lo, &hi, &clipped);
+    STAT_ADD(stats_local(), cut[STAT_BOUND], (unsigned long long)clipped);
+#else
+    bool ok = DFS_FN(dfs_frame_range)(st, d, &lo, &hi, NULL);
+#endif
+    f->wrap_lo = 1;
+    f->wrap_hi = 0;
+    if (!ok)
+    {
+        f->next = 1;
+        f->max_next = 0;
+        return;
+    }
+    f->next = lo;
+    f->max_next = hi;
+    if (st->hint)
+    {
+        /* Hint order: start at the LUT ruler's gap, then the candidates
+         * above it, those below it last. */
+        int h = st->pos[d - 1] + st->hint[d] - st->hint[d - 1];
+        if (h > lo && h <= hi)
+        {
+            f->next = h;
+            f->wrap_lo = lo;
+            f->wrap_hi = h - 1;
+        }
+    }
+}
+
+/* Branch-and-bound: the incumbent improved, so every open frame is clipped
+ * to the new bound (cursors stay, only max_next and, in hint order, the
+ * pending wrap_hi shrink). */
+static void DFS_FN(dfs_stack_tighten)(dfs_stack_t *st, int target_len)
+{
+    st->target_len = target_len;
+    for (int d = st->base; d <= st->depth && d < st->n; ++d)
+    {
+        dfs_frame_t *f = &st->frame[d];
+        int lo, hi;
+        if (f->next <= f->max_next)
+        {
+            lo = f->next;
+            if (!DFS_FN(dfs_frame_range)(st, d, &lo, &hi, NULL))
+                f->max_next = f->next - 1;
+            else if (hi < f->max_next)
+                f->max_next = hi;
+        }
+        if (f->wrap_lo <= f->wrap_hi)
+        {
+            lo = f->wrap_lo;
+            if (!DFS_FN(dfs_frame_range)(st, d, &lo, &hi, NULL))
+                f->wrap_hi = f->wrap_lo - 1;
+            else if (hi < f->wrap_hi)
+                f->wrap_hi = hi;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * dfs_stack_run -- Continue the search for at most `budget` committed nodes
+ * (budget <= 0: unlimited).
+ *
+ * Returns DFS_FOUND with the ruler in st->pos, DFS_SUSPENDED when the budget
+ * ran out, or DFS_EXHAUSTED when the subtree holds no (further) ruler.
+ * --------------------------------------------------------------------------- */
+DFS_RUN_LINKAGE int DFS_FN(dfs_stack_run)(dfs_stack_t *st, long long budget)
+{
+    const int n = DFS_NMARKS(st);
+    const int base = st->base;
+    int *pos = st->pos;
+    uint64_t *dist_bs = st->dist_bs;
+    int *best = st->best;
+    int d = st->depth;
+    long long nodes = 0;        /* committed in this call (st->nodes) */
+#ifdef GOLOMB_STATS
+    search_stats_t *stats = stats_local();
+#endif
+
+    if (base >= n)
+    {
+        /* Prefix is already a full ruler: report it once. */
+        if (d != base)
+            return DFS_EXHAUSTED;
+        st->depth = base + 1;
+        if (best)
+            return (pos[n - 1] < __atomic_load_n(best, __ATOMIC_RELAXED)) ? DFS_FOUND : DFS_EXHAUSTED;
+        return (pos[n - 1] == st->target_len) ? DFS_FOUND : DFS_EXHAUSTED;
+    }
+
+    if (best && __atomic_load_n(best, __ATOMIC_RELAXED) - 1 < st->target_len)
+        DFS_FN(dfs_stack_tighten)(st, __atomic_load_n(best, __ATOMIC_RELAXED) - 1);
+
+    for (;;)
+    {
+        dfs_frame_t *f = &st->frame[d];
+        if (f->next > f->max_next)
+        {
+            if (f->wrap_lo <= f->wrap_hi)
+            {
+                /* Hint order: now the candidates below the hint. */
+                f->next = f->wrap_lo;
+                f->max_next = f->wrap_hi;
+                f->wrap_hi = f->wrap_lo - 1;
+                continue;
+            }
+            if (d == base)
+            {
+                st->depth = d;
+                st->nodes += nodes;
+                return DFS_EXHAUSTED;
+            }
+            /* Pop: clear the distances the parent's mark committed. */
+            --d;
+            const int *pd = st->frame[d].dists;
+            for (int i = 0; i < d; ++i)
+                clr_bit(dist_bs, pd[i]);
+            continue;
+        }
+
+        int next = f->next++;
+        int last = pos[d - 1];
+
+        /* Quick scalar pre-check: the gap to the immediate predecessor
+         * is the most likely duplicate (smallest new distance). */
+        if (test_bit_scalar(dist_bs, next - last))
+        {
+            STAT_ADD(stats, cut[STAT_PRE_GAP], 1);
+            continue;
+        }
+
+        /* Compute all distances from `next` to every placed mark. */
+        int *dists = f->dists;
+        bool ok = true;
+#if DFS_KERNEL_N
+        /* Fixed width n-1, fully unrolled and vectorised. Lanes beyond d get
+         * distance 0, whose bit is never set, so the duplicate test can
+         * sweep all lanes without a mask or an early exit. */
+        uint64_t hit = 0;
+#pragma GCC unroll 32
+        for (int i = 0; i < DFS_KERNEL_N - 1; ++i)
+            dists[i] = (i < d) ? next - pos[i] : 0;
+#pragma GCC unroll 32
+        for (int i = 0; i < DFS_KERNEL_N - 1; ++i)
+            hit |= dist_bs[dists[i] >> 6] >> (dists[i] & 63);
+        ok = !(hit & 1);
+#else
+        for (int i = 0; i < d; ++i)
+            dists[i] = next - pos[i];
+
+        /* Check for duplicates: SIMD path (8 at a time) or scalar. */
+#ifdef DFS_DUP8
+        if (d >= 8) {
+            int i = 0;
+            for (; i + 8 <= d; i += 8) {
+                if (DFS_DUP8(dist_bs, &dists[i], st->bs_words)) { ok = false; break; }
+            }
+            if (ok) {
+                for (; i < d; ++i) {
+                    if (test_bit_scalar(dist_bs, dists[i])) { ok = false; break; }
+                }
+            }
+        } else
+#endif
+        {
+            for (int i = 0; i < d; ++i) {
+                if (test_bit_scalar(dist_bs, dists[i])) {
+                    ok = false;
+                    break;
+                }
+            }
+        }
+#endif
+        if (!ok)
+        {
+            STAT_ADD(stats, cut[STAT_DUP], 1);
+            continue;
+        }
+        STAT_ADD(stats, nodes[d], 1);
+
+        pos[d] = next;
+        if (d == n - 1)
+        {
+            /* Leaf: next == target_len by construction (next <= target_len
+             * in branch-and-bound mode). Nothing committed, the cursor
+             * already points behind it, so the stack resumes. */
+            st->depth = d;
+            st->nodes += nodes;
+            return DFS_FOUND;
+        }
+
+        /* Commit: set all new distance bits (kept in the frame for rollback)
+         * and derive the child's distinct-gap bound incrementally. */
+        for (int i = 0; i < d; ++i)
+            set_bit(dist_bs, dists[i]);
+        dfs_frame_t *c = &st->frame[d + 1];
+        c->gap_sum = f->gap_sum;
+        c->gap_thr = f->gap_thr;
+        bounds_gap_sum_child(dist_bs, n - d - 1, dists, d, &c->gap_sum, &c->gap_thr);
+
+        if (st->verbose && d < 6)
+            printf("depth %d add %d\n", d, next);
+
+        /* Branch-and-bound: pick up a better incumbent (any thread). */
+        if (best && __atomic_load_n(best, __ATOMIC_RELAXED) - 1 < st->target_len)
+        {
+            st->depth = d;
+            DFS_FN(dfs_stack_tighten)(st, __atomic_load_n(best, __ATOMIC_RELAXED) - 1);
+        }
+
+        DFS_FN(dfs_frame_enter)(st, ++d);
+        ++nodes;
+        if (budget > 0 && --budget == 0)
+        {
+            st->depth = d;
+            st->nodes += nodes;
+            return DFS_SUSPENDED;
+        }
+    }
+}
+
+#undef DFS_NMARKS
+#undef DFS_FN
+#undef DFS_CAT
+#undef DFS_CAT_
+#undef DFS_RUN_LINKAGE
+#undef DFS_DUP8
+#undef DFS_SUFFIX
+#undef DFS_KERNEL_N
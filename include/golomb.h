@@ -12,6 +12,16 @@
 
 /* derived: number of 64-bit words needed, plus guard to avoid out-of-bounds gathers */
 #define BS_WORDS   ((MAX_LEN_BITSET >> 6) + 2)
+
+/* Live bitset width for rulers up to length L: 2, 4, 8 or 10 words (128 to
+ * 640 distances). Solvers clear, copy and test only these words; a width of
+ * 2/4 fits one AVX2 register, 8 one cache line / AVX-512 register. Words
+ * beyond it are never consulted for distances <= L. */
+static inline int bs_words_for(int L)
+{
+    int w = (L >> 6) + 1;
+    return (w <= 2) ? 2 : (w <= 4) ? 4 : (w <= 8) ? 8 : 10;
+}
 #ifndef __has_attribute
 #define __has_attribute(x) 0
 #endif
@@ -34,9 +44,340 @@ const ruler_t *lut_lookup_by_marks(int marks);
 /* Prints a ruler to stdout */
 void print_ruler(const ruler_t *r);
 
+/*--------- Bounds API (bounds.c) -----------------------------------------*/
+
+/* G(k): optimal length for k marks from the LUT (trivial bound beyond it). */
+extern int g_min_len[MAX_MARKS + 1];
+
+/* -bs: count how many candidate nodes each bound removed. */
+enum { BOUND_SUFFIX, BOUND_WINDOW, BOUND_GAPSUM, BOUND_KINDS };
+extern bool g_bound_stats;
+extern unsigned long long g_bound_cut[BOUND_KINDS];
+
+/* Builds g_min_len once (thread-safe). */
+void bounds_init(void);
+/* Clips the candidate range [*lo, *hi] of mark `depth` with the sub-ruler
+ * bounds; returns false if it became empty. */
+bool bounds_next_range(int depth, int n, int target_len, const int *pos, int *lo, int *hi);
+
+/* Distinct-gap bound: the k remaining gaps are distinct free distances, so
+ * they sum to at least S(k) = sum of the k smallest free distances (T is the
+ * largest of them). Engines keep (S, T) per frame and update it on commit. */
+int  bounds_gap_sum_scan(const uint64_t *bs, int k, int *thr);
+void bounds_gap_sum_child(const uint64_t *bs, int k, const int *added, int nadded,
+                          int *sum, int *thr);
+bool bounds_gap_sum_range(int last, int target_len, int sum, int thr, int *lo, int *hi);
+/* All bounds from scratch (for engines without frame state, e.g. dfs_asm);
+ * lohi = {lo, hi}. */
+bool bounds_frame_range(int depth, int n, int target_len, const int *pos,
+                        const uint64_t *dist_bs, int *lohi);
+void bounds_report(FILE *fp);
+
+/*--------- Iterative DFS engine (solver.c) ------------------------------*/
+
+/* Search state of one mark index: candidate cursor, bound, and the distances
+ * the placed mark committed (needed for rollback). */
+typedef struct {
+    int next;                   /* next candidate position to try */
+    int max_next;               /* last candidate position at this depth */
+    int wrap_lo, wrap_hi;       /* hint order: candidates below the hint,
+                                   tried after [next, max_next] */
+    int gap_sum;                /* distinct-gap bound S(n-depth) ... */
+    int gap_thr;                /* ... and its largest free distance T */
+    int dists[MAX_MARKS];       /* distances committed by pos[depth] */
+} __attribute__((aligned(64))) dfs_frame_t;
+
+/* Explicit DFS stack. Preallocate one per thread; frames [base, depth] are
+ * open, pos[0..base-1] is the fixed prefix of the subtree. */
+typedef struct {
+    int n;
+    int target_len;
+    int base;                   /* depth of the subtree root */
+    int depth;                  /* frame currently being iterated */
+    bool verbose;
+    int *best;                  /* B&B: shared incumbent (rulers must be
+                                   shorter); NULL: ruler ends at target_len */
+    int bs_words;               /* live width of dist_bs (bs_words_for) */
+    const int *hint;            /* -ho: marks of the LUT ruler for n; NULL:
+                                   ascending order (always with best) */
+    long long nodes;            /* nodes committed since init (progress) */
+    int pos[MAX_MARKS];
+    uint64_t dist_bs[BS_WORDS];
+    dfs_frame_t frame[MAX_MARKS];
+} __attribute__((aligned(64))) dfs_stack_t;
+
+/* Compact, position-independent description of a suspended stack. */
+typedef struct {
+    int n;
+    int target_len;
+    int base;
+    int depth;
+    int pos[MAX_MARKS];         /* placed marks pos[0..depth-1] */
+    int next[MAX_MARKS];        /* cursor of each open frame base..depth */
+} dfs_snapshot_t;
+
+enum { DFS_EXHAUSTED = 0, DFS_FOUND = 1, DFS_SUSPENDED = 2 };
+
+void dfs_stack_init(dfs_stack_t *st, int depth, int n, int target_len,
+                    const int *pos, const uint64_t *dist_bs, bool verbose);
+/* Branch-and-bound variant: target_len follows *best - 1, shrinking as the
+ * incumbent improves; every DFS_FOUND is a ruler with pos[n-1] < *best. */
+void dfs_stack_init_bb(dfs_stack_t *st, int depth, int n, const int *pos,
+                       const uint64_t *dist_bs, int *best, bool verbose);
+/* Runs for at most `budget` committed nodes (<= 0: unlimited). Returns one of
+ * DFS_FOUND (ruler in st->pos, stack resumable), DFS_SUSPENDED, DFS_EXHAUSTED. */
+int dfs_stack_run(dfs_stack_t *st, long long budget);
+void dfs_stack_snapshot(const dfs_stack_t *st, dfs_snapshot_t *snap);
+bool dfs_stack_restore(dfs_stack_t *st, const dfs_snapshot_t *snap, bool verbose);
+
+/* Engine bodies specialised for one mark count (dfs_kernels.c, generated
+ * from dfs_engine.h, one table per instruction set built in); NULL where
+ * none exists. dfs_stack_run calls the table chosen once for this CPU. */
+typedef int (*dfs_run_fn)(dfs_stack_t *st, long long budget);
+/* Instruction set levels (x86-64 psABI: base, v2, v3, v4). */
+enum { ISA_BASE = 0, ISA_SSE42 = 1, ISA_AVX2 = 2, ISA_AVX512 = 3 };
+/* Level this CPU runs (cpuid; GOLOMB_ISA=<name> caps it) and its name. */
+int cpu_isa(void);
+const char *cpu_isa_name(int isa);
+/* Table the dispatcher uses: "avx512", "avx2", "sse42", "native" or "none". */
+const char *dfs_kernels_isa(void);
+
+/* Compact unit of work for the work-stealing pool: marks pos[0..depth-1]
+ * are fixed, the mark at index `depth` is restricted to [lo, hi]. */
+typedef struct {
+    int depth;
+    int lo;
+    int hi;
+    int pos[MAX_MARKS];
+} dfs_task_t;
+
+/* Prepares the search of a task (prefix distances rebuilt); false if the
+ * prefix itself repeats a distance. */
+bool dfs_stack_init_task(dfs_stack_t *st, int n, int target_len, const dfs_task_t *t);
+/* Hands the upper half of the untried candidates of the shallowest open
+ * frame with at least `min_rest` marks left to place to *t (in hint order
+ * the candidates below the hint, if still pending); the stack keeps the
+ * rest. Returns false if no frame qualifies. */
+bool dfs_stack_split(dfs_stack_t *st, dfs_task_t *t, int min_rest);
+/* The untried work of a suspended stack as at most DFS_MAX_REMAINING
+ * tasks, up to two per open frame with candidates left, deepest first
+ * (checkpointing). */
+#define DFS_MAX_REMAINING (2 * MAX_MARKS)
+int dfs_stack_remaining(const dfs_stack_t *st, dfs_task_t *t);
+
+/*--------- Work-stealing pool (workpool.c) ------------------------------*/
+
+/* Fills root task i; returns false if root i needs no search. */
+typedef bool (*wp_root_fn)(void *ctx, long long i, dfs_task_t *t);
+/* Called once per root whose whole subtree (all parts) was searched. */
+typedef void (*wp_root_done_fn)(void *ctx, long long i);
+
+/* One piece of a root's subtree: a whole root, a split, or the remainder
+ * of an interrupted stack. */
+typedef struct {
+    long long root;
+    dfs_task_t t;
+} wp_part_t;
+/* Receives the unfinished parts of all roots in flight (a consistent cut). */
+typedef void (*wp_save_fn)(void *save_ctx, const wp_part_t *parts, long long nparts);
+
+/* Snapshot hooks of a pool run. */
+typedef struct {
+    const wp_part_t *parts;     /* resume: searched first, their roots are
+                                   not started again */
+    long long nparts;
+    wp_save_fn save;            /* NULL: no snapshots */
+    void *save_ctx;
+    int interval;               /* seconds between save() calls */
+} wp_cp_t;
+
+/* Worker count of the pool (-T, else all cores). */
+int wp_num_threads(void);
+/* Searches roots 0..nroots-1 (handed out in this order) on a pthread pool
+ * with per-thread deques; idle workers make busy ones split off their
+ * shallowest untried branch. Stops at the first ruler of length target_len.
+ * on_done may be NULL. */
+bool wp_solve(int n, int target_len, long long nroots, wp_root_fn root,
+              wp_root_done_fn on_done, void *ctx, ruler_t *out);
+/* Same, resuming the parts in cp and handing cp->save a snapshot of every
+ * in-flight root each cp->interval seconds (cp may be NULL). */
+bool wp_solve_cp(int n, int target_len, long long nroots, wp_root_fn root,
+                 wp_root_done_fn on_done, void *ctx, const wp_cp_t *cp, ruler_t *out);
+/* Same, with the `nlane` roots in `lane` as top priority: claimed first,
+ * their splits taken before any other work, busy ones split on demand. */
+bool wp_solve_lane(int n, int target_len, long long nroots, wp_root_fn root,
+                   wp_root_done_fn on_done, void *ctx, const wp_cp_t *cp,
+                   const long long *lane, long long nlane, ruler_t *out);
+/* Searches the roots of nlens L values at once: lens[s] (ascending) owns
+ * roots first[s]..first[s+1]-1, smallest L first. A ruler cancels every
+ * larger L; the result is the shortest ruler of the window, false if no
+ * L in it has one. No checkpoints, no on_done. */
+bool wp_solve_window(int n, int nlens, const int *lens, const long long *first,
+                     wp_root_fn root, void *ctx, const long long *lane, long long nlane,
+                     ruler_t *out);
+/* Set from another thread to make the running wp_solve() return false
+ * within one engine slice; the setter clears it again. */
+extern int g_wp_cancel;
+
+/*--------- Checkpoint files (checkpoint.c) ------------------------------*/
+
+/* Progress of one fan-out over `total` roots: the GRCP done-bitset plus
+ * (format v2) the unfinished parts of the roots in flight at the last save.
+ * A file only matches the same key and total. */
+typedef struct cp_state cp_state_t;
+
+/* Root list a checkpoint indexes (see checkpoint.c). */
+enum { CP_ROOTS_PREFIX = 0, CP_ROOTS_CREATIVE = 1, CP_ROOTS_ENDPOINT = 2 };
+
+typedef struct {
+    int n, L;
+    int kind;                   /* CP_ROOTS_* */
+    int hs, ht, hint_used;      /* LUT pair ordering the roots (0, 0, 0: none) */
+} cp_key_t;
+
+/* Root total of a matching v2..v4 file at path (fixes the prefix depth),
+ * or 0. */
+long long cp_peek_total(const char *path, const cp_key_t *key);
+/* Bitset for `total` roots; with a path, a matching v2..v4 file is loaded
+ * and the file is (re)written at once (with g_cp_mmap a v4 file is mapped
+ * instead). NULL if out of memory. */
+cp_state_t *cp_open(const char *path, const cp_key_t *key, long long total);
+/* Second and third mark of root i of a CP_ROOTS_PREFIX list. */
+typedef void (*cp_pair_fn)(const void *ctx, long long i, int *second, int *third);
+/* cp_open for a prefix list: the bits of a version 1 file for (n, L),
+ * which index (second, third) pairs, are carried over to the roots through
+ * pair() (called only inside cp_open_prefix). */
+cp_state_t *cp_open_prefix(const char *path, const cp_key_t *key, long long total,
+                           cp_pair_fn pair, const void *pair_ctx);
+/* True if cp writes a file. */
+bool cp_active(const cp_state_t *cp);
+bool cp_is_done(const cp_state_t *cp, long long i);
+/* Thread-safe, one atomic OR; the flusher thread writes (or msyncs) the
+ * file. */
+void cp_mark_done(cp_state_t *cp, long long i);
+/* Parts of unfinished roots loaded from the file (for wp_cp_t). */
+const wp_part_t *cp_resume_parts(const cp_state_t *cp, long long *nparts);
+/* Replaces the saved parts by a snapshot (copied) and has the flusher
+ * write the file. */
+void cp_save_parts(cp_state_t *cp, const wp_part_t *parts, long long nparts);
+/* Fills h for wp_solve_cp (resume parts, snapshots every -fi seconds);
+ * NULL when cp writes no file. */
+const wp_cp_t *cp_pool_hooks(cp_state_t *cp, wp_cp_t *h);
+/* Stops the flusher, writes the file a last time, then frees cp (NULL is
+ * ignored). */
+void cp_close(cp_state_t *cp);
+
+/* L sweep recorded in a checkpoint file (see checkpoint.c). */
+typedef struct {
+    int L;              /* length the file belongs to */
+    int sweep_lo;       /* first L of its sweep, 0 = unknown */
+    bool complete;      /* all roots of L done: L has no ruler */
+} cp_sweep_t;
+bool cp_sweep_peek(const char *path, int n, cp_sweep_t *s);
+/* First L of the running sweep, written into every file (0: none). */
+extern int g_cp_sweep_lo;
+/* -fm: keep header and bitset mapped, persist by msync. */
+extern bool g_cp_mmap;
+
+/*--------- Exported -mp fan-out (solver.c) -----------------------------*/
+
+/* The -mp root prefixes of one L with their done-bitset (GRCP checkpoint),
+ * shared by the distributed coordinator and its workers. */
+typedef struct mp_fanout mp_fanout_t;
+/* Depth k (0: adaptive for `threads`), LUT order if `hints`; `checkpoint`
+ * uses -f. NULL if out of memory or no roots. */
+mp_fanout_t *mp_fanout_open(int n, int L, int k, int threads, bool hints, bool checkpoint);
+long long mp_fanout_total(const mp_fanout_t *f);
+int mp_fanout_depth(const mp_fanout_t *f);
+bool mp_fanout_hints(const mp_fanout_t *f);
+bool mp_fanout_is_done(const mp_fanout_t *f, long long i);
+void mp_fanout_mark_done(mp_fanout_t *f, long long i);
+/* Searches roots [lo, hi) on the local pool. */
+bool mp_fanout_solve(mp_fanout_t *f, long long lo, long long hi, ruler_t *out);
+void mp_fanout_close(mp_fanout_t *f);
+
+/*--------- Distributed search (distrib.c) -------------------------------*/
+
+/* -serve <addr>: search length L with the workers connected to addr
+ * ("host:port", ":port" or "unix:/path"); the listener and the workers
+ * persist across calls until dist_shutdown(). */
+bool dist_coordinate(const char *addr, int n, int L, ruler_t *out, bool verbose);
+void dist_shutdown(void);
+/* -worker <addr>: serve leases until the coordinator says BYE; returns the
+ * process exit status. */
+int dist_worker(const char *addr, bool verbose);
+
+/*--------- Subtree-size estimator (estimate.c) --------------------------*/
+
+/* Knuth's estimator: mean of `probes` random walks, estimated number of
+ * nodes the engine commits below task t (deterministic per seed). */
+double estimate_subtree(int n, int L, const dfs_task_t *t, int probes, uint64_t seed);
+/* Probe walks spent on one fan-out by estimate_roots(). */
+#define EST_PROBE_BUDGET (1 << 16)
+/* Estimated node count of the roots 0..nroots-1 of a pool fan-out. */
+double estimate_roots(int n, int L, long long nroots, wp_root_fn root, void *ctx,
+                      double *per_root);
+/* -vt: estimate each search up front (costly for small n). */
+extern bool g_estimate;
+/* Estimate for the running search (0: none) and nodes committed so far by
+ * the pool workers; the heartbeat derives progress and ETA from both. */
+extern double g_est_nodes;
+extern unsigned long long g_nodes_done;
+
+/*--------- Search statistics (stats.c, make STATS=1) --------------------*/
+
+/* Why a candidate was dropped: the pre-check of the gap to the previous
+ * mark, the full duplicate test, or the bounds (candidates clipped from a
+ * frame's range by bounds.c). */
+enum { STAT_PRE_GAP, STAT_DUP, STAT_BOUND, STAT_KINDS };
+
+#ifdef GOLOMB_STATS
+/* One thread's counters, padded to whole cache lines. Only the owning
+ * thread writes; readers sum all threads with relaxed loads. */
+typedef struct {
+    unsigned long long nodes[MAX_MARKS];    /* marks placed at index d */
+    unsigned long long cut[STAT_KINDS];     /* candidates dropped per reason */
+} __attribute__((aligned(64))) search_stats_t;
+
+extern __thread search_stats_t *g_stats_tls;
+search_stats_t *stats_claim(void);
+
+/* The calling thread's counters (claimed on first use). */
+static inline search_stats_t *stats_local(void)
+{
+    search_stats_t *s = g_stats_tls;
+    return s ? s : stats_claim();
+}
+
+/* Owner-only increment: a plain load/add/store, no locked instruction. */
+#define STAT_ADD(s, field, v) \
+    __atomic_store_n(&(s)->field, __atomic_load_n(&(s)->field, __ATOMIC_RELAXED) + (v), __ATOMIC_RELAXED)
+
+void stats_sum(search_stats_t *out);
+/* Totals, nodes/s over `seconds` and prune ratios (stdout / result file). */
+void stats_report(FILE *fp, double seconds);
+void stats_write(FILE *fp, double seconds);
+/* -vt heartbeat line (node rate since the previous call, `now` = run time). */
+void stats_tick(FILE *fp, double now);
+#else
+#define STAT_ADD(s, field, v) ((void)0)
+#endif
+
+/*--------- Hardware counters (perfctr.c) --------------------------------*/
+
+/* -hw: count cycles, instructions, branch and L1d misses per solver run
+ * (perf_event_open; switches itself off where not permitted). */
+extern bool g_perf;
+bool perf_begin(void);
+/* Stops the counters and adds them to the totals; nodes: 0 if unknown. */
+void perf_end(double nodes);
+void perf_report(FILE *fp);
+void perf_write(FILE *fp);
+
 /*--------- Solver API (solver.c) ----------------------------------------*/
 
-/* Recursive branch&bound search function, now public */
+/* Branch&bound search below pos[0..depth-1] (runs the iterative engine on a
+ * per-thread stack). Fills pos[depth..n-1] on success. */
 bool dfs(int depth, int n, int target_len, int *pos, uint64_t *dist_bs, bool verbose);
 
 /*
@@ -51,6 +392,39 @@ bool solve_golomb_traditional_opt(int n, int target_length, ruler_t *out, bool v
 
 /* Multi-threaded variant (OpenMP). Explores top-level branches in parallel. */
 bool solve_golomb_mt(int n, int target_length, ruler_t *out, bool verbose);
+/* Subtree kernel plugged into the prefix fan-out. On entry pos[0..depth-1]
+ * and all prefix distances in dist_bs are set (depth is 3 unless a resumed
+ * checkpoint fixes another one); on success the kernel fills
+ * pos[depth..n-1] and returns true. */
+typedef bool (*prefix_kernel_fn)(int depth, int n, int target_len, int *pos, uint64_t *dist_bs);
+
+/* Static prefix fan-out of -mp (ordering, fast lane, checkpoint) with a
+ * caller-supplied subtree kernel. solve_golomb_mt uses dfs(). */
+bool solve_golomb_prefix_mt(int n, int target_length, ruler_t *out, bool verbose,
+                            prefix_kernel_fn kernel);
+
+/* -sw: -mp over L0 .. L0+nlens-1 in one pool (at most L_WINDOW_MAX);
+ * returns the shortest ruler among them. */
+#define L_WINDOW_MAX 8
+bool solve_golomb_window_mt(int n, int L0, int nlens, ruler_t *out, bool verbose);
+
+/* Bit-parallel shift-register engine (-sr, solver_shift.c). */
+bool dfs_shift(int depth, int n, int target_len, int *pos, uint64_t *dist_bs);
+bool solve_golomb_shift(int n, int target_length, ruler_t *out, bool verbose);
+
+/* Single-pass branch-and-bound for the minimum length (-bb): finds the
+ * shortest n-mark ruler of length < upper and proves it optimal. `parallel`
+ * fans the search out over OpenMP threads sharing one lock-free incumbent. */
+bool solve_golomb_bb(int n, int upper, ruler_t *out, bool verbose, bool parallel);
+/* Incumbent of the running -bb search (rulers shorter than this are sought);
+ * 0 when no search is running. */
+extern int g_bb_best;
+
+/* Enumeration (-ea, solver_enum.c): counts every n-mark ruler of length
+ * exactly L, mirror images once, and streams each to `sink` as one line of
+ * positions (sink may be NULL). Never cancels; -1 if out of memory. */
+long long enumerate_golomb(int n, int L, FILE *sink, bool parallel);
+
 /* Dynamic OpenMP task-based solver (enable with -d) */
 bool solve_golomb_mt_dyn(int n, int target_length, ruler_t *out, bool verbose);
 
@@ -63,12 +437,15 @@ bool solve_golomb_physics(int n, int target_length, ruler_t *out, bool verbose);
 /* Evolutionary solver: Genetic algorithm with distance-aware crossover */
 bool solve_golomb_evolutionary(int n, int target_length, ruler_t *out, bool verbose);
 
-/* NASM assembler solver (-mpa): LUT fast-lane, no checkpoint */
+/* NASM assembler solver (-mpa): -mp prefix fan-out with the asm kernel */
 bool solve_golomb_mt_asm(int n, int target_length, ruler_t *out, int verbose);
 
 
 /* Global runtime flag: 1 => use AVX2 SIMD path where available */
 extern bool g_use_simd;
+/* -ho: LUT value order inside the dfs engine; -hk: fast lane depth. */
+extern bool g_hint_order;
+extern int g_lane_marks;
 
 /* Checkpoint/Resume control (used by -mp solver). If g_cp_path != NULL, the
  * solver periodically writes progress and can resume from that file. Interval
@@ -10,7 +10,8 @@ section .data
 section .bss
     align 64
     pos_buf:     resd 32        ; int pos[MAX_MARKS]
-    dist_buf:    resq 11        ; uint64_t dist_bs[BS_WORDS=11]
+    dist_buf:    resq 11        ; uint64_t dist_bs[BS_WORDS=11]; only the live
+                                ; width (LIVE_WORDS) is cleared/used per L
 
 section .text
 
@@ -19,6 +20,31 @@ section .text
 %define BS_WORDS 11
 %define MAX_LEN_BITSET 600
 
+; %1 (32-bit reg) = live bitset words for target_length in r14d, matching
+; bs_words_for() in golomb.h: (L >> 6) + 1 rounded up to 2, 4, 8 or 10.
+%macro LIVE_WORDS 1
+    mov     %1, r14d
+    shr     %1, 6
+    inc     %1
+    cmp     %1, 2
+    jbe     %%w2
+    cmp     %1, 4
+    jbe     %%w4
+    cmp     %1, 8
+    jbe     %%w8
+    mov     %1, 10
+    jmp     %%done
+%%w2:
+    mov     %1, 2
+    jmp     %%done
+%%w4:
+    mov     %1, 4
+    jmp     %%done
+%%w8:
+    mov     %1, 8
+%%done:
+%endmacro
+
 ; Externe C-Funktionen
 extern printf
 extern memcpy
@@ -26,6 +52,7 @@ extern getenv
 extern lut_lookup_by_marks
 extern test_any_dup8_avx2_gather
 extern g_use_simd
+extern bounds_frame_range
 
 ; Exportierte Funktionen
 global dfs_asm
@@ -172,9 +199,29 @@ dfs_asm:
     cmovg   ecx, eax            ; max_next = min(max_next, limit)
 
 .no_sym_break:
-    ; Loop: for (next = last+1; next <= max_next; next++)
-    mov     r11d, r10d
-    inc     r11d                ; r11d = next (start at last+1)
+    ; LUT sub-ruler + distinct-gap bounds (bounds.c): clip [last+1, max_next]
+    ; bool bounds_frame_range(depth, n, target_len, pos, dist_bs, lohi)
+    mov     eax, r10d
+    inc     eax
+    mov     [rbp - 64], eax     ; lo = last + 1
+    mov     [rbp - 60], ecx     ; hi = max_next
+    mov     [rbp - 72], r9      ; verbose (caller-saved)
+    mov     [rbp - 80], r10     ; last (caller-saved)
+    mov     edi, r15d
+    mov     esi, r14d
+    mov     edx, r13d
+    mov     rcx, r12
+    mov     r8, rbx
+    lea     r9, [rbp - 64]      ; lohi = {lo, hi}
+    call    bounds_frame_range
+    mov     r10, [rbp - 80]
+    mov     r9, [rbp - 72]
+    test    al, al
+    jz      .ret_false
+
+    ; Loop: for (next = lo; next <= hi; next++)
+    mov     ecx, [rbp - 60]     ; ecx = max_next (clipped)
+    mov     r11d, [rbp - 64]    ; r11d = next (start at clipped lo)
 
 .next_loop:
     cmp     r11d, ecx
@@ -414,9 +461,9 @@ solve_golomb_mt_asm_unused:
     lea     rbx, [pos_buf]
     lea     r12, [dist_buf]
 
-    ; Zero dist_buf
+    ; Zero dist_buf (live words)
     xor     rax, rax
-    mov     rcx, BS_WORDS
+    LIVE_WORDS ecx
 .zero_dist:
     mov     [r12 + rcx*8 - 8], rax
     dec     rcx
@@ -465,9 +512,9 @@ solve_golomb_mt_asm_unused:
     cmp     r9d, ecx
     jg      .skip_fastlane
 
-    ; reset dist_buf
+    ; reset dist_buf (live words)
     xor     rax, rax
-    mov     rdx, BS_WORDS
+    LIVE_WORDS edx
 .fastlane_zero:
     mov     [r12 + rdx*8 - 8], rax
     dec     rdx
@@ -575,10 +622,10 @@ solve_golomb_mt_asm_unused:
     cmp     r9d, ecx
     jg      .next_second
 
-    ; Reset dist_buf
+    ; Reset dist_buf (live words)
     xor     rax, rax
     push    rcx
-    mov     rcx, BS_WORDS
+    LIVE_WORDS ecx
 .reset_dist:
     mov     [r12 + rcx*8 - 8], rax
     dec     rcx
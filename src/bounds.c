@@ -0,0 +1,257 @@
+/* ==========================================================================
+ * BOUNDS.C — Sub-Ruler Lower Bounds from the Optimal-Ruler LUT
+ * ==========================================================================
+ *
+ * Every k consecutive marks of a Golomb ruler form a Golomb ruler of their
+ * own, so they span at least G(k), the optimal length for k marks. lut.c
+ * knows G(k) for k <= 28; beyond that the trivial k(k-1)/2 is used.
+ *
+ * When the mark at index d is placed at `next` (marks 0..d-1 fixed, last
+ * mark on L):
+ *
+ *   suffix bound:  marks d..n-1 span L - next, hence
+ *                      next <= L - G(n - d)
+ *                  (the solvers used to assume gaps of 1, i.e. n-d-1)
+ *
+ *   window bound:  marks i..d span next - pos[i], hence
+ *                      next >= pos[i] + G(d - i + 1)   for every i < d
+ *
+ * Both only clip the candidate range of a frame, so they cost O(depth) per
+ * node and nothing per candidate. Windows are restricted to sub-rulers with
+ * fewer than n marks: G(n) itself is never consulted, so the search for n
+ * marks still proves its own optimum.
+ *
+ * Distinct-gap bound:
+ *   The n-d gaps still to be placed between the last mark and L are pairwise
+ *   distinct and none of them may be a distance that is already measured.
+ *   So they sum to at least S(k), the sum of the k = n-d smallest distances
+ *   that are still free in dist_bs:
+ *
+ *                      last + S(n - d) <= L
+ *                      next <= L - (S(n - d) - T)
+ *
+ *   where T is the largest of those k free distances (the candidate's own
+ *   gap is one of the k, the other k-1 sum to at least S - T). The engines
+ *   keep (S, T) per frame and update it on commit with
+ *   bounds_gap_sum_child(), which only touches the few new distances that
+ *   fall below T, so the bitset is scanned from scratch only at a subtree
+ *   root or on restore. Rollback is free (the parent frame keeps its pair).
+ *
+ * Statistics (-bs): when g_bound_stats is set, every solver reports how many
+ * candidate nodes each bound removed.
+ * ========================================================================== */
+
+#include "golomb.h"
+#include <pthread.h>
+#include <stdio.h>
+
+int g_min_len[MAX_MARKS + 1];
+bool g_bound_stats = false;
+unsigned long long g_bound_cut[BOUND_KINDS];
+
+static pthread_once_t g_bounds_once = PTHREAD_ONCE_INIT;
+
+static void bounds_build(void)
+{
+    for (int k = 0; k <= MAX_MARKS; ++k) {
+        const ruler_t *r = lut_lookup_by_marks(k);
+        int trivial = (k > 1) ? k * (k - 1) / 2 : 0;
+        g_min_len[k] = (r && r->length > trivial) ? r->length : trivial;
+    }
+}
+
+/* Builds the G(k) table once; cheap to call from every solver entry. */
+void bounds_init(void)
+{
+    pthread_once(&g_bounds_once, bounds_build);
+}
+
+static inline void bound_count(int kind, int removed)
+{
+    if (removed > 0)
+        __atomic_fetch_add(&g_bound_cut[kind], (unsigned long long)removed, __ATOMIC_RELAXED);
+}
+
+/* ---------------------------------------------------------------------------
+ * bounds_next_range -- Clip the candidate range [*lo, *hi] of the mark at
+ * index `depth` (pos[0..depth-1] placed, ruler ends at target_len).
+ *
+ * Returns false if no candidate survives.
+ * --------------------------------------------------------------------------- */
+bool bounds_next_range(int depth, int n, int target_len, const int *pos, int *lo, int *hi)
+{
+    int l = *lo;
+    int h = *hi;
+
+    /* Suffix: the remaining n-depth marks form a ruler ending at L. */
+    int ub = target_len - g_min_len[n - depth];
+    if (ub < h) {
+        if (g_bound_stats)
+            bound_count(BOUND_SUFFIX, h - (ub >= l ? ub : l - 1));
+        h = ub;
+    }
+
+    /* Windows: marks i..depth form a ruler of depth-i+1 < n marks. */
+    int i0 = depth - n + 2;
+    if (i0 < 0) i0 = 0;
+    int lb = l;
+    for (int i = i0; i < depth - 1; ++i) {
+        int v = pos[i] + g_min_len[depth - i + 1];
+        if (v > lb) lb = v;
+    }
+    if (lb > l) {
+        if (g_bound_stats)
+            bound_count(BOUND_WINDOW, (lb <= h ? lb : h + 1) - l);
+        l = lb;
+    }
+
+    *lo = l;
+    *hi = h;
+    return l <= h;
+}
+
+/* ==================== Distinct-gap bound ==================== */
+
+/* Smallest free distance > x (distances beyond the bitset count as free). */
+static inline int next_free(const uint64_t *bs, int x)
+{
+    int y = x + 1;
+    int w = y >> 6;
+    if (w >= BS_WORDS)
+        return y;
+    uint64_t m = ~bs[w] & (~0ULL << (y & 63));
+    while (!m) {
+        if (++w >= BS_WORDS)
+            return w << 6;
+        m = ~bs[w];
+    }
+    return (w << 6) + __builtin_ctzll(m);
+}
+
+/* Largest free distance in [1, x-1], or 0 if there is none. */
+static inline int prev_free(const uint64_t *bs, int x)
+{
+    int y = x - 1;
+    if (y < 1)
+        return 0;
+    int w = y >> 6;
+    if (w >= BS_WORDS)
+        return y;
+    uint64_t m = ~bs[w] & (~0ULL >> (63 - (y & 63)));
+    for (;;) {
+        if (w == 0)
+            m &= ~1ULL; /* distance 0 is not a gap */
+        if (m)
+            return (w << 6) + 63 - __builtin_clzll(m);
+        if (--w < 0)
+            return 0;
+        m = ~bs[w];
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * bounds_gap_sum_scan -- S(k) from scratch; *thr receives T.
+ * --------------------------------------------------------------------------- */
+int bounds_gap_sum_scan(const uint64_t *bs, int k, int *thr)
+{
+    int sum = 0;
+    int t = 0;
+    for (int i = 0; i < k; ++i) {
+        t = next_free(bs, t);
+        sum += t;
+    }
+    *thr = t;
+    return sum;
+}
+
+/* ---------------------------------------------------------------------------
+ * bounds_gap_sum_child -- Incremental update after a commit.
+ *
+ * On entry (*sum, *thr) describe the k+1 smallest free distances of the
+ * parent; bs already contains the `nadded` new distances. On exit they
+ * describe the k smallest free distances of the child.
+ *
+ * The parent's chosen set C is exactly the free distances <= T. New
+ * distances above T leave it untouched; the r new ones inside C drop out and
+ * are replaced by the next free distances above T.
+ * --------------------------------------------------------------------------- */
+void bounds_gap_sum_child(const uint64_t *bs, int k, const int *added, int nadded,
+                          int *sum, int *thr)
+{
+    if (k <= 0) {
+        *sum = 0;
+        *thr = 0;
+        return;
+    }
+    int s = *sum;
+    int t = *thr;
+    int r = 0;
+    for (int i = 0; i < nadded; ++i) {
+        if (added[i] <= t) {
+            s -= added[i];
+            ++r;
+        }
+    }
+    if (r == 0) {
+        /* One gap fewer: drop the largest member. */
+        s -= t;
+        t = prev_free(bs, t);
+    } else {
+        /* k+1-r members remain; refill r-1 from above T. */
+        int top = prev_free(bs, t + 1);
+        int u = t;
+        for (int j = 1; j < r; ++j) {
+            u = next_free(bs, u);
+            s += u;
+        }
+        t = (r == 1) ? top : u;
+    }
+    *sum = s;
+    *thr = t;
+}
+
+/* ---------------------------------------------------------------------------
+ * bounds_gap_sum_range -- Apply the distinct-gap bound to a frame whose last
+ * mark is `last` and whose remaining gaps have bound (sum, thr).
+ * --------------------------------------------------------------------------- */
+bool bounds_gap_sum_range(int last, int target_len, int sum, int thr, int *lo, int *hi)
+{
+    if (last + sum > target_len) {
+        if (g_bound_stats)
+            bound_count(BOUND_GAPSUM, *hi - *lo + 1);
+        return false;
+    }
+    int ub = target_len - (sum - thr);
+    if (ub < *hi) {
+        if (g_bound_stats)
+            bound_count(BOUND_GAPSUM, *hi - (ub >= *lo ? ub : *lo - 1));
+        *hi = ub;
+    }
+    return *lo <= *hi;
+}
+
+/* ---------------------------------------------------------------------------
+ * bounds_frame_range -- All bounds for one frame, computed from scratch.
+ *
+ * Used by engines without per-frame state (NASM dfs_asm): lohi[0..1] is the
+ * candidate range [lo, hi] of mark `depth`, dist_bs holds the prefix.
+ * --------------------------------------------------------------------------- */
+bool bounds_frame_range(int depth, int n, int target_len, const int *pos,
+                        const uint64_t *dist_bs, int *lohi)
+{
+    if (!bounds_next_range(depth, n, target_len, pos, &lohi[0], &lohi[1]))
+        return false;
+    int thr;
+    int sum = bounds_gap_sum_scan(dist_bs, n - depth, &thr);
+    return bounds_gap_sum_range(pos[depth - 1], target_len, sum, thr, &lohi[0], &lohi[1]);
+}
+
+/* Prints the -bs statistics collected so far. */
+void bounds_report(FILE *fp)
+{
+    static const char *names[BOUND_KINDS] = { "suffix G(n-d)", "window G(k)", "distinct gaps S(n-d)" };
+    fprintf(fp, "[Bounds] candidate nodes removed:");
+    for (int k = 0; k < BOUND_KINDS; ++k)
+        fprintf(fp, " %s=%llu", names[k], g_bound_cut[k]);
+    fprintf(fp, "\n");
+}
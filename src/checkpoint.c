@@ -0,0 +1,762 @@
+/* ==========================================================================
+ * CHECKPOINT.C — GRCP Checkpoint Files (-f, -fi)
+ * ==========================================================================
+ *
+ * A fan-out over `total` root prefixes keeps one bit per root: set once the
+ * root's whole subtree is searched. Version 1 files hold only this bitset,
+ * so every root that was in flight when the process died started over; at
+ * n >= 18 a single root can take hours.
+ *
+ * Version 2 appends the unfinished parts of the in-flight roots, taken from
+ * a consistent snapshot of the work-stealing pool (wp_solve_cp): each
+ * running DFS stack becomes one task per open frame (its untried cursor
+ * range below the current path, dfs_stack_remaining), queued splits are
+ * stored as they are. A resumed pool searches these parts first and does
+ * not restart their roots, so a partially explored subtree continues where
+ * the snapshot was taken.
+ *
+ * Root lists: a file is only valid for the root list it indexes, so the
+ * header names it (kind) together with the ordering inputs:
+ *
+ *   CP_ROOTS_PREFIX    prefix_build() list of -mp, -sr, -mpa, -d, -serve;
+ *                      depth implied by total, order by the hint pair
+ *   CP_ROOTS_CREATIVE  -c: root i = second mark i + 1
+ *   CP_ROOTS_ENDPOINT  -to: root i = second mark i + 1, last mark at L
+ *
+ * L sweep: main.c searches L = start, start + 1, ... and each L opens a new
+ * file over the old one. The header keeps the first L of the sweep
+ * (sweep_lo), so a file for L also records that sweep_lo .. L-1 were
+ * searched in full without a ruler, and a file whose bits are all set
+ * proves L itself infeasible. cp_sweep_peek() gives main.c the L to
+ * continue at after a restart; any exact solver may pick it up, whatever
+ * kind of file proved the lower lengths.
+ *
+ * Layout (little-endian):
+ *
+ *   header   64 bytes  "GRCP", version, n, L, total (u64), hint_s, hint_t,
+ *                      hint_used, nparts (v2; padding in v1), kind (v3),
+ *                      sweep_lo (v3, 0: unknown), flags (v4), parts_sum
+ *                      (v4: FNV-1a of the part records), 8 bytes reserved;
+ *                      v1/v2 headers end after nparts (40 bytes), v3
+ *                      headers after sweep_lo (48 bytes)
+ *   bitset   4 * ceil(total / 32) bytes, bit i = root i done
+ *   parts    nparts * 80 bytes (v2): root (u64), depth, lo, hi, 0 (u16),
+ *            pos[32] (u16) -- marks pos[0..depth-1] fixed, the next mark
+ *            restricted to [lo, hi]
+ *
+ * Version 2 and 3 files load as before (v2 as a prefix-list file); parts
+ * of a v4 file whose records do not match parts_sum are dropped. Every
+ * write goes to <file>.tmp and is renamed over <file>.
+ *
+ * Version 1: the first release indexed the raw (second, third) pairs,
+ * s <= min(L/2, T-1), s < t <= T with T = L-(n-3), in (score, s, t) order
+ * (score: L1 distance to hint_s/hint_t when hint_used, else 0). Today's
+ * prefix list is bounds-filtered and up to 6 marks deep, so the indices do
+ * not carry over: cp_open_prefix rebuilds that pair order and marks every
+ * root whose second and third mark form a done pair, whatever the hint
+ * setting and depth of the run. A v1 file that does not have that pair
+ * count, or that a caller without the pairs opens, is refused and left as
+ * it is (the run goes on without a file).
+
+ * Writer: workers only set bits (one atomic OR in cp_mark_done) and hand
+ * over part snapshots (cp_save_parts copies them). A flusher thread per
+ * file copies the bitset and writes the file every -fi seconds and after
+ * each snapshot, off the search threads. SIGINT and SIGTERM wake it for a
+ * last write before the process ends with the signal's default action.
+ *
+ * Mapped (-fm): the file is opened in place instead and header plus bitset
+ * are mapped MAP_SHARED, so cp_mark_done sets the bit in the page cache and
+ * a resume reads nothing but the header and the parts. The flusher msyncs
+ * the mapping every -fi seconds (the kernel writes back only dirty pages);
+ * a snapshot writes its records behind the bitset, syncs them, and only
+ * then stores nparts and parts_sum in the mapped header (flags bit 0 set).
+ * A crash between the two leaves records that fail the checksum; they are
+ * dropped and their roots start over. Files of another version or key are
+ * rewritten as v4 once, then mapped.
+
+ * Soundness: the saved parts may be older than the bitset they are written
+ * with. That is safe: parts of roots done by then are dropped, and the
+ * parts of any other root cover at least what was left of it.
+ * ========================================================================== */
+
+#define _POSIX_C_SOURCE 200809L   /* sigaction, poll, mmap, pread */
+#include "golomb.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CP_VERSION 4
+#define CP_HEADER_V2 40  /* bytes of a v1/v2 header */
+#define CP_HEADER_V3 48
+#define CP_FLAG_MAPPED 1u
+
+const char *g_cp_path = NULL;
+int g_cp_interval_sec = 60; /* default 60s */
+int g_cp_sweep_lo = 0;
+bool g_cp_mmap = false;
+
+typedef struct {
+    char magic[4];      /* "GRCP" */
+    uint32_t version;   /* 1..3 */
+    uint32_t n;
+    uint32_t L;
+    uint64_t total;
+    uint32_t hint_s;
+    uint32_t hint_t;
+    uint32_t hint_used; /* 0/1 */
+    uint32_t nparts;    /* v2: part records behind the bitset */
+    uint32_t kind;      /* v3: CP_ROOTS_* */
+    uint32_t sweep_lo;  /* v3: first L of the sweep, 0 = unknown */
+    uint32_t flags;     /* v4: CP_FLAG_MAPPED */
+    uint32_t parts_sum; /* v4: cp_sum of the part records */
+    uint32_t reserved[2];
+} cp_header_t;
+
+typedef struct {
+    uint64_t root;
+    uint16_t depth, lo, hi, reserved;
+    uint16_t pos[MAX_MARKS];
+} cp_part_rec_t;
+
+struct cp_state {
+    const char *path;           /* NULL: bitset only, no file */
+    cp_key_t key;
+    long long total;
+    uint32_t *done_words;       /* bitset: 1 = root processed */
+    size_t words;
+    wp_part_t *resume;          /* parts loaded from the file */
+    long long nresume;
+    wp_part_t *parts;           /* latest snapshot, NULL: none yet */
+    long long nparts;
+    int interval;
+    pthread_mutex_t io;         /* parts, nparts */
+    pthread_t flusher;
+    int wake[2];                /* pipe to the flusher: 'p' parts, 'q' quit */
+    int fd;                     /* -fm: the file, -1: not mapped */
+    uint8_t *map;               /* -fm: header + bitset */
+    size_t map_len;
+    cp_pair_fn pair;            /* prefix lists: (second, third) of a root */
+    const void *pair_ctx;
+};
+
+/* The file-backed cp with a running flusher (one at a time), for the
+ * signal handler. */
+static cp_state_t *volatile g_cp_live;
+static volatile sig_atomic_t g_cp_signal;
+static struct sigaction g_cp_old_int, g_cp_old_term;
+
+/* FNV-1a over the part records of a v4 file. */
+static uint32_t cp_sum(const void *data, size_t len)
+{
+    const uint8_t *b = (const uint8_t*)data;
+    uint32_t h = 2166136261u;
+    for (size_t k = 0; k < len; ++k)
+        h = (h ^ b[k]) * 16777619u;
+    return h;
+}
+
+/* Reads and checks the header, upgrading older versions in memory (v1: no
+ * parts, v1/v2: prefix list). */
+static bool cp_read_header(FILE *fp, cp_header_t *h)
+{
+    memset(h, 0, sizeof *h);
+    if (fread(h, 1, CP_HEADER_V2, fp) != CP_HEADER_V2 || memcmp(h->magic, "GRCP", 4) != 0)
+        return false;
+    if (h->version < 1 || h->version > CP_VERSION)
+        return false;
+    if (h->version == 1)
+        h->nparts = 0;
+    size_t size = h->version < 3 ? CP_HEADER_V2 : h->version == 3 ? CP_HEADER_V3 : sizeof *h;
+    if (h->version < 3)
+        h->kind = CP_ROOTS_PREFIX;
+    return fread(&h->kind, 1, size - CP_HEADER_V2, fp) == size - CP_HEADER_V2;
+}
+
+static bool cp_header_matches(const cp_header_t *h, const cp_key_t *k)
+{
+    return h->n == (uint32_t)k->n && h->L == (uint32_t)k->L && h->kind == (uint32_t)k->kind &&
+           h->hint_s == (uint32_t)k->hs && h->hint_t == (uint32_t)k->ht &&
+           h->hint_used == (uint32_t)k->hint_used;
+}
+
+long long cp_peek_total(const char *path, const cp_key_t *key)
+{
+    if (!path || !*path) return 0;
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return 0;
+    cp_header_t h;
+    bool ok = cp_read_header(fp, &h);
+    fclose(fp);
+    if (!ok || h.version == 1 || !cp_header_matches(&h, key))
+        return 0;                   /* v1 totals count pairs, not roots */
+    return (long long)h.total;
+}
+
+/* ---------------------------------------------------------------------------
+ * cp_sweep_peek -- Where the L sweep that wrote `path` stands for n marks:
+ * its L, its first L (0 if the file does not say) and whether every root of
+ * L is done. False if there is no readable file for n.
+ * --------------------------------------------------------------------------- */
+bool cp_sweep_peek(const char *path, int n, cp_sweep_t *s)
+{
+    if (!path || !*path) return false;
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return false;
+    cp_header_t h;
+    bool ok = cp_read_header(fp, &h) && h.n == (uint32_t)n && h.total > 0;
+    long long done = 0;
+    uint32_t w;
+    for (uint64_t k = 0; ok && k < (h.total + 31) / 32; ++k)
+    {
+        if (fread(&w, sizeof w, 1, fp) != 1) { ok = false; break; }
+        done += __builtin_popcount(w);
+    }
+    fclose(fp);
+    if (!ok)
+        return false;
+    s->L = (int)h.L;
+    s->sweep_lo = (int)h.sweep_lo;
+    s->complete = done >= (long long)h.total;
+    return true;
+}
+
+typedef struct { int s, t, score; } cp_pair_t;
+
+static int cp_pair_cmp(const void *a, const void *b)
+{
+    const cp_pair_t *x = (const cp_pair_t*)a;
+    const cp_pair_t *y = (const cp_pair_t*)b;
+    if (x->score != y->score) return x->score - y->score;
+    if (x->s != y->s) return x->s - y->s;
+    return x->t - y->t;
+}
+
+/* Refuses the file at cp->path: the run goes on without writing it. */
+static int cp_refuse(cp_state_t *cp, const char *why)
+{
+    fprintf(stderr, "[CP] %s: %s; file left unchanged, running without checkpoint\n",
+            cp->path, why);
+    cp->path = NULL;
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * cp_load_v1 -- Carries the bitset of a version 1 file for (n, L), read
+ * from fp behind its header, over to cp's prefix roots (see the header
+ * comment). Returns 1, or refuses the file (0).
+ * --------------------------------------------------------------------------- */
+static int cp_load_v1(cp_state_t *cp, FILE *fp, const cp_header_t *h)
+{
+    const int n = cp->key.n, L = cp->key.L;
+    const int T = L - (n - 3);
+    int smax = L / 2;
+    if (smax > T - 1) smax = T - 1;
+    if (smax < 1) smax = 1;
+    long long count = 0;
+    for (int s = 1; s <= smax; ++s)
+        if (T - s > 0) count += T - s;
+    if (!cp->pair)
+        return cp_refuse(cp, "version 1 file, this solver cannot read its (second, third) pairs");
+    if (count <= 0 || h->total != (uint64_t)count)
+        return cp_refuse(cp, "version 1 file with an unexpected pair count");
+
+    size_t words = (size_t)((count + 31) / 32);
+    uint32_t *bits = (uint32_t*)malloc(words * sizeof(uint32_t));
+    cp_pair_t *pairs = (cp_pair_t*)malloc((size_t)count * sizeof(cp_pair_t));
+    unsigned char *done = (unsigned char*)calloc((size_t)(smax + 1) * (size_t)(T + 1), 1);
+    if (!bits || !pairs || !done || fread(bits, sizeof(uint32_t), words, fp) != words)
+    {
+        bool oom = !bits || !pairs || !done;
+        free(bits);
+        free(pairs);
+        free(done);
+        return cp_refuse(cp, oom ? "out of memory reading the version 1 file"
+                                 : "version 1 file is truncated");
+    }
+    long long k = 0;
+    for (int s = 1; s <= smax; ++s)
+        for (int t = s + 1; t <= T; ++t)
+        {
+            int score = 0;
+            if (h->hint_used)
+            {
+                int ds = s - (int)h->hint_s, dt = t - (int)h->hint_t;
+                score = (ds < 0 ? -ds : ds) + (dt < 0 ? -dt : dt);
+            }
+            pairs[k++] = (cp_pair_t){ s, t, score };
+        }
+    if (h->hint_used)
+        qsort(pairs, (size_t)count, sizeof(cp_pair_t), cp_pair_cmp);
+    long long npairs = 0;
+    for (long long j = 0; j < count; ++j)
+        if ((bits[j >> 5] >> (j & 31)) & 1u)
+        {
+            done[(size_t)pairs[j].s * (size_t)(T + 1) + (size_t)pairs[j].t] = 1;
+            ++npairs;
+        }
+    long long nroots = 0;
+    for (long long i = 0; i < cp->total; ++i)
+    {
+        int s, t;
+        cp->pair(cp->pair_ctx, i, &s, &t);
+        if (s >= 1 && s <= smax && t > s && t <= T && done[(size_t)s * (size_t)(T + 1) + (size_t)t])
+        {
+            cp_mark_done(cp, i);
+            ++nroots;
+        }
+    }
+    free(bits);
+    free(pairs);
+    free(done);
+    printf("[CP] %s: version 1 file, %lld of %lld (second, third) pairs done -> %lld of %lld roots\n",
+           cp->path, npairs, count, nroots, cp->total);
+    return 1;
+}
+
+/* Loads bitset and parts of a matching file; parts of done roots and
+ * malformed records are dropped. Returns the file's version, 0 if it was
+ * not loaded. With `bits` false the bitset is not read: the caller maps a
+ * v4 file and keeps done_words zero otherwise (and must drop the parts). */
+static int cp_load(cp_state_t *cp, bool bits)
+{
+    FILE *fp = fopen(cp->path, "rb");
+    if (!fp) return 0;
+    cp_header_t h;
+    bool ok = cp_read_header(fp, &h);
+    if (ok && h.version == 1 && cp->key.kind == CP_ROOTS_PREFIX &&
+        h.n == (uint32_t)cp->key.n && h.L == (uint32_t)cp->key.L)
+    {
+        int v = bits ? cp_load_v1(cp, fp, &h) : 0;
+        fclose(fp);
+        return v;
+    }
+    if (!ok ||
+        !cp_header_matches(&h, &cp->key) ||
+        h.total != (uint64_t)cp->total)
+    {
+        fclose(fp);
+        return 0;
+    }
+    size_t want = cp->words * sizeof(uint32_t);
+    if (bits ? fread(cp->done_words, 1, want, fp) != want
+             : fseek(fp, (long)want, SEEK_CUR) != 0)
+    {
+        memset(cp->done_words, 0, want);
+        fclose(fp);
+        return 0;
+    }
+    cp_part_rec_t *recs = NULL;
+    if (h.nparts > 0)
+    {
+        recs = (cp_part_rec_t*)malloc((size_t)h.nparts * sizeof(cp_part_rec_t));
+        cp->resume = (wp_part_t*)malloc((size_t)h.nparts * sizeof(wp_part_t));
+    }
+    uint32_t nrecs = 0;
+    if (recs && cp->resume)
+        nrecs = (uint32_t)fread(recs, sizeof(cp_part_rec_t), h.nparts, fp);
+    if (h.version >= 4 && (nrecs != h.nparts ||
+                           cp_sum(recs, (size_t)nrecs * sizeof(cp_part_rec_t)) != h.parts_sum))
+        nrecs = 0;                  /* torn -fm snapshot: restart those roots */
+    for (uint32_t k = 0; k < nrecs; ++k)
+    {
+        const cp_part_rec_t r = recs[k];
+        if (r.root >= (uint64_t)cp->total || r.depth < 1 || r.depth >= cp->key.n ||
+            (bits && cp_is_done(cp, (long long)r.root)))
+            continue;
+        wp_part_t *p = &cp->resume[cp->nresume++];
+        p->root = (long long)r.root;
+        p->t.depth = r.depth;
+        p->t.lo = r.lo;
+        p->t.hi = r.hi;
+        for (int j = 0; j < r.depth; ++j)
+            p->t.pos[j] = r.pos[j];
+    }
+    free(recs);
+    fclose(fp);
+    return (int)h.version;
+}
+
+/* Records of the parts of roots not done yet (the latest snapshot, else the
+ * resumed parts); *live is their count. NULL if there are none. */
+static cp_part_rec_t *cp_records(cp_state_t *cp, uint32_t *live)
+{
+    cp_part_rec_t *recs = NULL;
+    *live = 0;
+    pthread_mutex_lock(&cp->io);
+    const wp_part_t *src = cp->parts ? cp->parts : cp->resume;
+    long long nsrc = cp->parts ? cp->nparts : cp->nresume;
+    if (nsrc > 0)
+        recs = (cp_part_rec_t*)calloc((size_t)nsrc, sizeof(cp_part_rec_t));
+    for (long long k = 0; recs && k < nsrc; ++k)
+    {
+        const wp_part_t *p = &src[k];
+        if (cp_is_done(cp, p->root))
+            continue;
+        cp_part_rec_t *r = &recs[(*live)++];
+        r->root = (uint64_t)p->root;
+        r->depth = (uint16_t)p->t.depth;
+        r->lo = (uint16_t)p->t.lo;
+        r->hi = (uint16_t)(p->t.hi < MAX_LEN_BITSET ? p->t.hi : MAX_LEN_BITSET);
+        for (int j = 0; j < p->t.depth; ++j)
+            r->pos[j] = (uint16_t)p->t.pos[j];
+    }
+    pthread_mutex_unlock(&cp->io);
+    return recs;
+}
+
+static void cp_fill_header(const cp_state_t *cp, cp_header_t *h, const cp_part_rec_t *recs,
+                           uint32_t live)
+{
+    memset(h, 0, sizeof *h);
+    memcpy(h->magic, "GRCP", 4);
+    h->version = CP_VERSION;
+    h->n = (uint32_t)cp->key.n;
+    h->L = (uint32_t)cp->key.L;
+    h->total = (uint64_t)cp->total;
+    h->hint_s = (uint32_t)cp->key.hs;
+    h->hint_t = (uint32_t)cp->key.ht;
+    h->hint_used = (uint32_t)cp->key.hint_used;
+    h->nparts = live;
+    h->kind = (uint32_t)cp->key.kind;
+    h->sweep_lo = (g_cp_sweep_lo > 0 && g_cp_sweep_lo <= cp->key.L) ? (uint32_t)g_cp_sweep_lo : 0;
+    h->parts_sum = cp_sum(recs, (size_t)live * sizeof(cp_part_rec_t));
+}
+
+/* Writes header, a copy of the bitset and the parts of roots not done yet
+ * to <file>.tmp and renames it over the file. Only the flusher, or the
+ * opening/closing thread while there is none, calls it; never while the
+ * file is mapped. */
+static bool cp_write(cp_state_t *cp)
+{
+    char tmp[1024];
+    snprintf(tmp, sizeof tmp, "%s.tmp", cp->path);
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp) return false;
+
+    /* Records first: a root may be marked done while we write. */
+    uint32_t live;
+    cp_part_rec_t *recs = cp_records(cp, &live);
+    uint32_t *bits = (uint32_t*)malloc(cp->words * sizeof(uint32_t));
+    for (size_t w = 0; bits && w < cp->words; ++w)
+        bits[w] = __atomic_load_n(&cp->done_words[w], __ATOMIC_RELAXED);
+
+    cp_header_t h;
+    cp_fill_header(cp, &h, recs, live);
+    bool ok = bits && fwrite(&h, 1, sizeof h, fp) == sizeof h &&
+              fwrite(bits, sizeof(uint32_t), cp->words, fp) == cp->words &&
+              fwrite(recs, sizeof(cp_part_rec_t), live, fp) == live;
+    free(bits);
+    free(recs);
+    if (fclose(fp) != 0) ok = false;
+    if (!ok || rename(tmp, cp->path) != 0)
+    {
+        remove(tmp);
+        return false;
+    }
+    return true;
+}
+
+/* -fm: maps header and bitset of the v4 file at path (just written or
+ * loaded, so it matches cp) and moves done_words into the mapping. Parts
+ * loaded without the bitset lose the roots that turn out done. */
+static bool cp_map(cp_state_t *cp)
+{
+    int fd = open(cp->path, O_RDWR);
+    if (fd < 0)
+        return false;
+    size_t len = sizeof(cp_header_t) + cp->words * sizeof(uint32_t);
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (uint64_t)st.st_size >= len)
+        map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+    cp->fd = fd;
+    cp->map = (uint8_t*)map;
+    cp->map_len = len;
+    free(cp->done_words);
+    cp->done_words = (uint32_t*)(cp->map + sizeof(cp_header_t));
+    ((cp_header_t*)cp->map)->flags |= CP_FLAG_MAPPED;
+    long long keep = 0;
+    for (long long k = 0; k < cp->nresume; ++k)
+        if (!cp_is_done(cp, cp->resume[k].root))
+            cp->resume[keep++] = cp->resume[k];
+    cp->nresume = keep;
+    return true;
+}
+
+/* -fm: writes the parts behind the bitset and syncs them, then publishes
+ * them in the mapped header and syncs the whole mapping. */
+static void cp_sync_parts(cp_state_t *cp)
+{
+    uint32_t live;
+    cp_part_rec_t *recs = cp_records(cp, &live);
+    if (live > 0 && !recs)
+        return;
+    size_t bytes = (size_t)live * sizeof(cp_part_rec_t);
+    off_t at = (off_t)cp->map_len;
+    bool ok = (bytes == 0 || pwrite(cp->fd, recs, bytes, at) == (ssize_t)bytes) &&
+              ftruncate(cp->fd, at + (off_t)bytes) == 0 && fdatasync(cp->fd) == 0;
+    if (ok)
+    {
+        cp_header_t h;
+        cp_fill_header(cp, &h, recs, live);
+        cp_header_t *m = (cp_header_t*)cp->map;
+        m->nparts = h.nparts;
+        m->parts_sum = h.parts_sum;
+        m->sweep_lo = h.sweep_lo;
+    }
+    free(recs);
+    msync(cp->map, cp->map_len, MS_SYNC);
+}
+
+/* Persists the file: a full rewrite, or with -fm a sync of the mapping
+ * (plus the parts if `parts`). */
+static void cp_persist(cp_state_t *cp, bool parts)
+{
+    if (!cp->map)
+        (void)cp_write(cp);
+    else if (parts)
+        cp_sync_parts(cp);
+    else
+        msync(cp->map, cp->map_len, MS_SYNC);
+}
+
+/* SIGINT/SIGTERM: let the flusher write once more, it then re-raises. */
+static void cp_on_signal(int sig)
+{
+    g_cp_signal = sig;
+    cp_state_t *cp = g_cp_live;
+    if (cp)
+    {
+        char c = 's';
+        ssize_t r = write(cp->wake[1], &c, 1);
+        (void)r;
+    }
+    else
+    {
+        signal(sig, SIG_DFL);
+        raise(sig);
+    }
+}
+
+/* Ends the process with a signal that arrived while a file was open. */
+static void cp_reraise(void)
+{
+    int sig = g_cp_signal;
+    if (!sig)
+        return;
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void *cp_flusher(void *arg)
+{
+    cp_state_t *cp = (cp_state_t*)arg;
+    for (;;)
+    {
+        struct pollfd pfd;
+        pfd.fd = cp->wake[0];
+        pfd.events = POLLIN;
+        int r = poll(&pfd, 1, cp->interval * 1000);
+        bool quit = false, parts = false;
+        if (r > 0)
+        {
+            char buf[64];
+            ssize_t k = read(cp->wake[0], buf, sizeof buf);
+            for (ssize_t j = 0; j < k; ++j)
+            {
+                quit |= (buf[j] == 'q');
+                parts |= (buf[j] != 'q');
+            }
+        }
+        if (quit)
+            return NULL;            /* cp_close writes the last time */
+        cp_persist(cp, parts);
+        cp_reraise();
+    }
+}
+
+/* Starts the flusher and routes SIGINT/SIGTERM to it; false if the thread
+ * cannot be started (the file is then only written by cp_close). */
+static bool cp_start_flusher(cp_state_t *cp)
+{
+    if (pipe(cp->wake) != 0)
+    {
+        cp->wake[0] = cp->wake[1] = -1;
+        return false;
+    }
+    if (pthread_create(&cp->flusher, NULL, cp_flusher, cp) != 0)
+    {
+        close(cp->wake[0]);
+        close(cp->wake[1]);
+        cp->wake[0] = cp->wake[1] = -1;
+        return false;
+    }
+    g_cp_live = cp;
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = cp_on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &g_cp_old_int);
+    sigaction(SIGTERM, &sa, &g_cp_old_term);
+    return true;
+}
+
+cp_state_t *cp_open(const char *path, const cp_key_t *key, long long total)
+{
+    return cp_open_prefix(path, key, total, NULL, NULL);
+}
+
+cp_state_t *cp_open_prefix(const char *path, const cp_key_t *key, long long total,
+                           cp_pair_fn pair, const void *pair_ctx)
+{
+    cp_state_t *cp = (cp_state_t*)calloc(1, sizeof *cp);
+    if (!cp)
+        return NULL;
+    cp->path = (path && *path) ? path : NULL;
+    cp->key = *key;
+    cp->pair = pair;
+    cp->pair_ctx = pair_ctx;
+    cp->total = total;
+    cp->words = (size_t)((total + 31) / 32);
+    if (cp->words == 0) cp->words = 1;
+    cp->done_words = (uint32_t*)calloc(cp->words, sizeof(uint32_t));
+    if (!cp->done_words)
+    {
+        free(cp);
+        return NULL;
+    }
+    cp->interval = (g_cp_interval_sec > 0) ? g_cp_interval_sec : 60;
+    cp->wake[0] = cp->wake[1] = -1;
+    cp->fd = -1;
+    pthread_mutex_init(&cp->io, NULL);
+    if (cp->path)
+    {
+        /* -fm on a v4 file: map it as it is, without reading the bitset. */
+        bool mapped = g_cp_mmap && cp_load(cp, false) == CP_VERSION && cp_map(cp);
+        if (!mapped)
+        {
+            free(cp->resume);
+            cp->resume = NULL;
+            cp->nresume = 0;
+            cp_load(cp, true);
+            /* Create or refresh the file at once so users can see it early
+             * (unless cp_load refused it). */
+            if (cp->path && cp_write(cp) && g_cp_mmap)
+                (void)cp_map(cp);
+        }
+        if (cp->path && !g_cp_live)
+            (void)cp_start_flusher(cp);
+    }
+    return cp;
+}
+
+bool cp_is_done(const cp_state_t *cp, long long i)
+{
+    return (__atomic_load_n(&cp->done_words[i >> 5], __ATOMIC_RELAXED) >> (i & 31)) & 1u;
+}
+
+void cp_mark_done(cp_state_t *cp, long long i)
+{
+    __atomic_fetch_or(&cp->done_words[i >> 5], 1u << (i & 31), __ATOMIC_RELAXED);
+}
+
+const wp_part_t *cp_resume_parts(const cp_state_t *cp, long long *nparts)
+{
+    *nparts = cp->nresume;
+    return cp->resume;
+}
+
+bool cp_active(const cp_state_t *cp)
+{
+    return cp && cp->path;
+}
+
+void cp_save_parts(cp_state_t *cp, const wp_part_t *parts, long long nparts)
+{
+    wp_part_t *copy = (wp_part_t*)malloc((size_t)(nparts > 0 ? nparts : 1) * sizeof(wp_part_t));
+    if (!copy)
+        return;                     /* keep the previous snapshot */
+    if (nparts > 0)
+        memcpy(copy, parts, (size_t)nparts * sizeof(wp_part_t));
+    pthread_mutex_lock(&cp->io);
+    free(cp->parts);
+    cp->parts = copy;
+    cp->nparts = nparts;
+    pthread_mutex_unlock(&cp->io);
+    if (cp->wake[1] >= 0)
+    {
+        char c = 'p';
+        ssize_t r = write(cp->wake[1], &c, 1);
+        (void)r;
+    }
+}
+
+static void cp_pool_save(void *ctx, const wp_part_t *parts, long long nparts)
+{
+    cp_save_parts((cp_state_t*)ctx, parts, nparts);
+}
+
+/* ---------------------------------------------------------------------------
+ * cp_pool_hooks -- Snapshot hooks for a pool run over cp's roots: resume
+ * with the loaded parts, save a snapshot every -fi seconds. Returns h, or
+ * NULL when cp writes no file (wp_solve_cp then runs without snapshots).
+ * --------------------------------------------------------------------------- */
+const wp_cp_t *cp_pool_hooks(cp_state_t *cp, wp_cp_t *h)
+{
+    if (!cp_active(cp))
+        return NULL;
+    h->parts = cp->resume;
+    h->nparts = cp->nresume;
+    h->save = cp_pool_save;
+    h->save_ctx = cp;
+    h->interval = cp->interval;
+    return h;
+}
+
+void cp_close(cp_state_t *cp)
+{
+    if (!cp)
+        return;
+    bool flusher = cp->wake[1] >= 0;
+    if (flusher)
+    {
+        char c = 'q';
+        ssize_t r = write(cp->wake[1], &c, 1);
+        (void)r;
+        pthread_join(cp->flusher, NULL);
+    }
+    if (cp->path)
+        cp_persist(cp, true);
+    if (cp->map)
+    {
+        munmap(cp->map, cp->map_len);
+        close(cp->fd);
+        cp->done_words = NULL;
+    }
+    if (flusher)
+    {
+        /* A signal from here on ends the process at once, as before. */
+        sigaction(SIGINT, &g_cp_old_int, NULL);
+        sigaction(SIGTERM, &g_cp_old_term, NULL);
+        g_cp_live = NULL;
+        close(cp->wake[0]);
+        close(cp->wake[1]);
+        cp_reraise();
+    }
+    pthread_mutex_destroy(&cp->io);
+    free(cp->resume);
+    free(cp->parts);
+    free(cp->done_words);
+    free(cp);
+}
@@ -0,0 +1,126 @@
+/* ==========================================================================
+ * DFS_KERNELS.C — DFS Engine Specialised per Mark Count (n = 8..28)
+ * ==========================================================================
+ *
+ * dfs() gets n at run time, so the distance loop `for (i = 0; i < d; ++i)`
+ * and the d >= 8 SIMD switch cannot be unrolled. Here the engine template
+ * (dfs_engine.h) is instantiated once per order with n as a compile-time
+ * constant: the n-1 distances of a candidate are computed and tested at
+ * fixed width, fully unrolled and vectorised by the compiler, and every
+ * n-dependent bound folds to a constant.
+ *
+ * The file is built once per instruction set: make FAT=1 compiles it with
+ * -march=x86-64-v2/-v3/-v4 and -DDFS_ISA=sse42/avx2/avx512 into the tables
+ * g_dfs_kernels_<isa>; the default build compiles it once for
+ * -march=native (g_dfs_kernels_native). solver.c picks the widest table
+ * the CPU runs once at start-up (cpuid) and dfs_stack_run() calls
+ * table[n]; orders outside 8..28 use the generic body. GOLOMB_NO_KERNELS=1
+ * disables the kernels for A/B measurements.
+ * ========================================================================== */
+
+#include "golomb.h"
+#include <string.h>
+
+/* Bitset helpers (duplicated here for compilation-unit locality). */
+static inline void set_bit(uint64_t *bs, int idx) { bs[idx >> 6] |= 1ULL << (idx & 63); }
+static inline void clr_bit(uint64_t *bs, int idx) { bs[idx >> 6] &= ~(1ULL << (idx & 63)); }
+static inline int  test_bit_scalar(const uint64_t *bs, int idx) { return (bs[idx >> 6] >> (idx & 63)) & 1ULL; }
+
+#define DFS_KERNEL_N 8
+#define DFS_SUFFIX _n8
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 9
+#define DFS_SUFFIX _n9
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 10
+#define DFS_SUFFIX _n10
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 11
+#define DFS_SUFFIX _n11
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 12
+#define DFS_SUFFIX _n12
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 13
+#define DFS_SUFFIX _n13
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 14
+#define DFS_SUFFIX _n14
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 15
+#define DFS_SUFFIX _n15
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 16
+#define DFS_SUFFIX _n16
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 17
+#define DFS_SUFFIX _n17
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 18
+#define DFS_SUFFIX _n18
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 19
+#define DFS_SUFFIX _n19
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 20
+#define DFS_SUFFIX _n20
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 21
+#define DFS_SUFFIX _n21
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 22
+#define DFS_SUFFIX _n22
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 23
+#define DFS_SUFFIX _n23
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 24
+#define DFS_SUFFIX _n24
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 25
+#define DFS_SUFFIX _n25
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 26
+#define DFS_SUFFIX _n26
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 27
+#define DFS_SUFFIX _n27
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 28
+#define DFS_SUFFIX _n28
+#include "dfs_engine.h"
+
+#ifndef DFS_ISA
+#define DFS_ISA native
+#endif
+#define DFS_TABLE_(isa) g_dfs_kernels_##isa
+#define DFS_TABLE(isa)  DFS_TABLE_(isa)
+
+const dfs_run_fn DFS_TABLE(DFS_ISA)[MAX_MARKS + 1] = {
+    [8] = dfs_stack_run_n8, [9] = dfs_stack_run_n9, [10] = dfs_stack_run_n10, [11] = dfs_stack_run_n11,
+    [12] = dfs_stack_run_n12, [13] = dfs_stack_run_n13, [14] = dfs_stack_run_n14, [15] = dfs_stack_run_n15,
+    [16] = dfs_stack_run_n16, [17] = dfs_stack_run_n17, [18] = dfs_stack_run_n18, [19] = dfs_stack_run_n19,
+    [20] = dfs_stack_run_n20, [21] = dfs_stack_run_n21, [22] = dfs_stack_run_n22, [23] = dfs_stack_run_n23,
+    [24] = dfs_stack_run_n24, [25] = dfs_stack_run_n25, [26] = dfs_stack_run_n26, [27] = dfs_stack_run_n27,
+    [28] = dfs_stack_run_n28,
+};
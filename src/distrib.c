@@ -0,0 +1,732 @@
+/* ==========================================================================
+ * DISTRIB.C — Coordinator/Worker Search over Sockets (-serve, -worker)
+ * ==========================================================================
+ *
+ * Beyond one machine the -mp fan-out is cut into leases: contiguous ranges
+ * of root prefix indices (mp_fanout_*, solver.c).
+ *
+ *   Coordinator (-serve addr):  runs the L loop like any solver. Per L it
+ *       builds the root list (adaptive depth as for DIST_THREADS workers,
+ *       LUT order unless GOLOMB_NO_HINTS) and owns its done-bitset, which
+ *       is the GRCP checkpoint with -f. It hands leases of about
+ *       total / DIST_LEASES roots to idle workers, in root order.
+ *
+ *   Worker (-worker addr):  rebuilds the same list from (n, L, depth,
+ *       hints) -- prefix_build() is deterministic -- and searches each
+ *       lease on its local work-stealing pool (-T threads).
+ *
+ * Addresses: "unix:/path" (Unix socket), "host:port" or ":port" (TCP; an
+ * empty host is the loopback interface on both sides, "*:port" lets the
+ * coordinator listen on all interfaces).
+ *
+ * Trust: there is no authentication. Any peer that can connect may take
+ * leases and report DONE for them, which marks their roots searched (an L
+ * can then look infeasible). Listen beyond loopback only on a network
+ * where every peer is a worker of this run.
+ *
+ * Protocol: one text line per message.
+ *
+ *   worker -> coordinator           coordinator -> worker
+ *   HELLO <threads>                 LEASE <n> <L> <id> <depth> <total>
+ *   DONE <L> <id>                         <hints> <lo> <hi>
+ *   FOUND <L> <id> <p0> ... <pn-1>  STOP     (abandon the running lease)
+ *   ABORT <L> <id>                  BYE      (exit)
+ *
+ *   Every LEASE is answered by exactly one DONE, FOUND or ABORT. Replies
+ *   for another L are ignored, so stale messages are harmless.
+ *
+ * Failures:
+ *   - a worker that disconnects (crash, kill) gives its lease back at once;
+ *   - a lease running longer than GOLOMB_DIST_SLOW seconds (default
+ *     DIST_SLOW_SEC) is issued a second time once nothing else is left;
+ *     the first DONE wins and the other copy is told to STOP;
+ *   - the first FOUND (checked to be a Golomb ruler of length L) ends the
+ *     L: every busy worker gets STOP, so all of them halt within one
+ *     engine slice (g_wp_cancel).
+ *
+ * Only fully searched leases are marked done, so a checkpoint written by
+ * the coordinator can be resumed by -mp and vice versa (same depth and
+ * hints).
+ *
+ * script/dist_local runs a coordinator and several workers on localhost.
+ * ========================================================================== */
+
+#define _POSIX_C_SOURCE 200809L
+#include "golomb.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DIST_MAX_CLIENTS  256
+#define DIST_LINE_MAX     512      /* longest message (FOUND with 32 marks) */
+#define DIST_LEASES       1024     /* target lease count per L */
+#define DIST_THREADS      256      /* root depth chosen as for this many */
+#define DIST_SLOW_SEC     300.0    /* re-issue leases older than this */
+#define DIST_POLL_MS      200
+#define DIST_CONNECT_TRY  100      /* worker: 100 x 100 ms to reach the coordinator */
+
+/* ==================== Sockets and line I/O ==================== */
+
+typedef struct {
+    int fd;
+    size_t len;
+    char buf[4 * DIST_LINE_MAX];
+} dist_conn_t;
+
+static double dist_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Listening (server) or connected socket for addr; -1 with errno set. */
+static int dist_socket(const char *addr, bool server)
+{
+    if (strncmp(addr, "unix:", 5) == 0)
+    {
+        const char *path = addr + 5;
+        struct sockaddr_un sa;
+        memset(&sa, 0, sizeof sa);
+        sa.sun_family = AF_UNIX;
+        if (strlen(path) >= sizeof sa.sun_path)
+        {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+        strcpy(sa.sun_path, path);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        if (server)
+        {
+            unlink(path);
+            if (bind(fd, (struct sockaddr*)&sa, sizeof sa) == 0 && listen(fd, 64) == 0)
+                return fd;
+        }
+        else if (connect(fd, (struct sockaddr*)&sa, sizeof sa) == 0)
+            return fd;
+        int e = errno;
+        close(fd);
+        errno = e;
+        return -1;
+    }
+
+    char host[256] = "";
+    const char *port = addr;
+    const char *colon = strrchr(addr, ':');
+    if (colon)
+    {
+        size_t hl = (size_t)(colon - addr);
+        if (hl >= sizeof host)
+            hl = sizeof host - 1;
+        memcpy(host, addr, hl);
+        host[hl] = '\0';
+        port = colon + 1;
+    }
+    struct addrinfo hints, *res, *ai;
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    const char *h = host[0] ? host : "localhost";
+    if (server && strcmp(host, "*") == 0)
+    {
+        hints.ai_flags = AI_PASSIVE;    /* all interfaces */
+        h = NULL;
+    }
+    if (getaddrinfo(h, port, &hints, &res) != 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    int fd = -1;
+    for (ai = res; ai; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+        int one = 1;
+        if (server)
+        {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+            if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 64) == 0)
+                break;
+        }
+        else if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+        {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+/* One recv() into the buffer; false on EOF, error or an overlong line. */
+static bool conn_fill(dist_conn_t *c)
+{
+    if (c->len == sizeof c->buf)
+        return false;
+    ssize_t r = recv(c->fd, c->buf + c->len, sizeof c->buf - c->len, 0);
+    if (r <= 0)
+        return r < 0 && errno == EINTR;
+    c->len += (size_t)r;
+    return true;
+}
+
+/* Takes the next complete line (without newline) out of the buffer. */
+static bool conn_line(dist_conn_t *c, char *line, size_t cap)
+{
+    char *nl = memchr(c->buf, '\n', c->len);
+    if (!nl)
+        return false;
+    size_t l = (size_t)(nl - c->buf);
+    size_t k = (l < cap - 1) ? l : cap - 1;
+    memcpy(line, c->buf, k);
+    line[k] = '\0';
+    c->len -= l + 1;
+    memmove(c->buf, nl + 1, c->len);
+    return true;
+}
+
+static bool conn_send(int fd, const char *fmt, ...)
+{
+    char msg[DIST_LINE_MAX];
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(msg, sizeof msg, fmt, ap);
+    va_end(ap);
+    if (len < 0 || len >= (int)sizeof msg)
+        return false;
+    for (int off = 0; off < len;)
+    {
+        ssize_t w = send(fd, msg + off, (size_t)(len - off), MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        off += (int)w;
+    }
+    return true;
+}
+
+/* ==================== Coordinator ==================== */
+
+typedef struct {
+    dist_conn_t conn;
+    int threads;
+    bool ready;                 /* HELLO received */
+    long long lease;            /* lease running for the current L, -1: idle */
+} dist_client_t;
+
+typedef struct {
+    long long lo, hi;           /* root range [lo, hi) */
+    int owners;                 /* workers running it */
+    bool done;
+    double issued;              /* time of the last issue */
+} dist_lease_t;
+
+static int g_listen_fd = -1;
+static char g_listen_path[256];  /* Unix socket to unlink on shutdown */
+static dist_client_t *g_clients[DIST_MAX_CLIENTS];
+static int g_nclients;
+
+static void dist_drop(int k, dist_lease_t *leases)
+{
+    dist_client_t *c = g_clients[k];
+    if (c->lease >= 0 && leases)
+        --leases[c->lease].owners;
+    printf("[DIST] worker %d left%s\n", c->conn.fd, c->lease >= 0 ? ", lease returned" : "");
+    close(c->conn.fd);
+    free(c);
+    g_clients[k] = g_clients[--g_nclients];
+}
+
+static void dist_accept(void)
+{
+    int fd = accept(g_listen_fd, NULL, NULL);
+    if (fd < 0)
+        return;
+    dist_client_t *c = (g_nclients < DIST_MAX_CLIENTS) ? (dist_client_t*)calloc(1, sizeof *c) : NULL;
+    if (!c)
+    {
+        close(fd);
+        return;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);  /* fails harmlessly on Unix sockets */
+    c->conn.fd = fd;
+    c->lease = -1;
+    g_clients[g_nclients++] = c;
+}
+
+/* Next lease to issue: the first one nobody runs, else (everything is out)
+ * a second copy of the oldest lease running for more than `slow` s. */
+static long long dist_pick(const dist_lease_t *ls, long long nl, double now, double slow)
+{
+    long long old = -1;
+    for (long long i = 0; i < nl; ++i)
+    {
+        if (ls[i].done)
+            continue;
+        if (ls[i].owners == 0)
+            return i;
+        if (ls[i].owners == 1 && now - ls[i].issued >= slow &&
+            (old < 0 || ls[i].issued < ls[old].issued))
+            old = i;
+    }
+    return old;
+}
+
+/* True if pos[0..n-1] is a Golomb ruler of length L starting at 0. */
+static bool dist_valid_ruler(const int *pos, int n, int L)
+{
+    uint64_t seen[BS_WORDS] = {0};
+    if (pos[0] != 0 || pos[n - 1] != L)
+        return false;
+    for (int j = 1; j < n; ++j)
+    {
+        if (pos[j] <= pos[j - 1])
+            return false;
+        for (int i = 0; i < j; ++i)
+        {
+            int d = pos[j] - pos[i];
+            if ((seen[d >> 6] >> (d & 63)) & 1)
+                return false;
+            seen[d >> 6] |= 1ULL << (d & 63);
+        }
+    }
+    return true;
+}
+
+/* Handles one message of client k; false if the client must be dropped. */
+static bool dist_message(dist_client_t *c, const char *line, int n, int L,
+                         dist_lease_t *leases, long long nleases, mp_fanout_t *f,
+                         long long *open, ruler_t *out, bool *found, bool verbose)
+{
+    int ml;
+    long long id;
+    int off;
+    if (sscanf(line, "HELLO %d", &c->threads) == 1)
+    {
+        c->ready = true;
+        printf("[DIST] worker %d joined (%d threads)\n", c->conn.fd, c->threads);
+        return true;
+    }
+    if (sscanf(line, "DONE %d %lld", &ml, &id) == 2)
+    {
+        if (ml != L || id < 0 || id >= nleases)
+            return true;
+        if (c->lease == id)
+        {
+            c->lease = -1;
+            --leases[id].owners;
+        }
+        if (!leases[id].done)
+        {
+            leases[id].done = true;
+            --*open;
+            for (long long i = leases[id].lo; i < leases[id].hi; ++i)
+                mp_fanout_mark_done(f, i);
+            if (verbose)
+                printf("[DIST] L=%d: lease %lld done, %lld open\n", L, id, *open);
+            /* A second copy of it is now pointless. */
+            for (int k = 0; k < g_nclients; ++k)
+                if (g_clients[k]->lease == id && conn_send(g_clients[k]->conn.fd, "STOP\n"))
+                {
+                    g_clients[k]->lease = -1;
+                    --leases[id].owners;
+                }
+        }
+        return true;
+    }
+    if (sscanf(line, "FOUND %d %lld%n", &ml, &id, &off) == 2)
+    {
+        if (ml != L)
+            return true;
+        int pos[MAX_MARKS];
+        const char *p = line + off;
+        int k = 0;
+        for (; k < n; ++k)
+        {
+            char *end;
+            long v = strtol(p, &end, 10);
+            if (end == p)
+                break;
+            pos[k] = (int)v;
+            p = end;
+        }
+        if (k != n || !dist_valid_ruler(pos, n, L))
+        {
+            fprintf(stderr, "[DIST] worker %d sent an invalid ruler, dropped\n", c->conn.fd);
+            return false;
+        }
+        if (c->lease == id)
+        {
+            c->lease = -1;
+            --leases[id].owners;
+        }
+        if (!*found)
+        {
+            *found = true;
+            out->marks = n;
+            out->length = L;
+            memcpy(out->pos, pos, (size_t)n * sizeof(int));
+        }
+        return true;
+    }
+    if (sscanf(line, "ABORT %d %lld", &ml, &id) == 2)
+    {
+        if (ml == L && c->lease == id)
+        {
+            c->lease = -1;
+            --leases[id].owners;
+        }
+        return true;
+    }
+    return true;  /* unknown messages are ignored */
+}
+
+/* ---------------------------------------------------------------------------
+ * dist_coordinate -- One L of the distributed search (see header comment).
+ * Returns true with the ruler in *out, false if no ruler of length L exists
+ * (or the root list could not be built).
+ * --------------------------------------------------------------------------- */
+bool dist_coordinate(const char *addr, int n, int L, ruler_t *out, bool verbose)
+{
+    if (n <= 3)
+        return solve_golomb(n, L, out, verbose);
+    if (g_listen_fd < 0)
+    {
+        g_listen_fd = dist_socket(addr, true);
+        if (g_listen_fd < 0)
+        {
+            fprintf(stderr, "[DIST] cannot listen on %s: %s\n", addr, strerror(errno));
+            return false;
+        }
+        if (strncmp(addr, "unix:", 5) == 0)
+            snprintf(g_listen_path, sizeof g_listen_path, "%s", addr + 5);
+        printf("[DIST] coordinator listening on %s\n", addr);
+    }
+
+    mp_fanout_t *f = mp_fanout_open(n, L, 0, DIST_THREADS, !getenv("GOLOMB_NO_HINTS"), true);
+    if (!f)
+        return false;
+    const long long total = mp_fanout_total(f);
+    const long long chunk = (total + DIST_LEASES - 1) / DIST_LEASES;
+    const long long nleases = (total + chunk - 1) / chunk;
+    dist_lease_t *leases = (dist_lease_t*)calloc((size_t)nleases, sizeof *leases);
+    if (!leases)
+    {
+        mp_fanout_close(f);
+        return false;
+    }
+    long long open = 0;
+    for (long long id = 0; id < nleases; ++id)
+    {
+        dist_lease_t *ls = &leases[id];
+        ls->lo = id * chunk;
+        ls->hi = (ls->lo + chunk < total) ? ls->lo + chunk : total;
+        ls->done = true;
+        for (long long i = ls->lo; i < ls->hi && ls->done; ++i)
+            ls->done = mp_fanout_is_done(f, i);   /* resumed from -f */
+        if (!ls->done)
+            ++open;
+    }
+    if (verbose)
+        printf("[DIST] L=%d: %lld roots of depth %d in %lld leases (%lld open)\n",
+               L, total, mp_fanout_depth(f), nleases, open);
+
+    const char *ev = getenv("GOLOMB_DIST_SLOW");
+    const double slow = (ev && atof(ev) > 0.0) ? atof(ev) : DIST_SLOW_SEC;
+    bool found = false;
+    bool waiting = false;
+    char line[DIST_LINE_MAX];
+
+    while (open > 0 && !found)
+    {
+        /* Hand out work. */
+        double now = dist_now();
+        int ready = 0;
+        for (int k = 0; k < g_nclients; ++k)
+        {
+            dist_client_t *c = g_clients[k];
+            if (!c->ready)
+                continue;
+            ++ready;
+            if (c->lease >= 0)
+                continue;
+            long long id = dist_pick(leases, nleases, now, slow);
+            if (id < 0)
+                break;
+            if (leases[id].owners > 0)
+                printf("[DIST] L=%d: lease %lld slow, issued again\n", L, id);
+            if (!conn_send(c->conn.fd, "LEASE %d %d %lld %d %lld %d %lld %lld\n", n, L, id,
+                           mp_fanout_depth(f), total, mp_fanout_hints(f) ? 1 : 0,
+                           leases[id].lo, leases[id].hi))
+                continue;   /* the read side notices the dead peer */
+            c->lease = id;
+            ++leases[id].owners;
+            leases[id].issued = now;
+        }
+        if (ready == 0 && !waiting)
+            printf("[DIST] L=%d: waiting for workers on %s\n", L, addr);
+        waiting = (ready == 0);
+        fflush(stdout);
+
+        struct pollfd pfd[DIST_MAX_CLIENTS + 1];
+        pfd[0].fd = g_listen_fd;
+        pfd[0].events = POLLIN;
+        for (int k = 0; k < g_nclients; ++k)
+        {
+            pfd[k + 1].fd = g_clients[k]->conn.fd;
+            pfd[k + 1].events = POLLIN;
+        }
+        int nfds = g_nclients + 1;
+        if (poll(pfd, (nfds_t)nfds, DIST_POLL_MS) <= 0)
+            continue;
+
+        /* Clients are dropped by swapping in the last one, so walk the
+         * poll array backwards. */
+        for (int k = nfds - 2; k >= 0; --k)
+        {
+            if (!(pfd[k + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            dist_client_t *c = g_clients[k];
+            bool keep = conn_fill(&c->conn);
+            while (keep && conn_line(&c->conn, line, sizeof line))
+                keep = dist_message(c, line, n, L, leases, nleases, f, &open, out, &found, verbose);
+            if (!keep)
+                dist_drop(k, leases);
+        }
+        if (pfd[0].revents & POLLIN)
+            dist_accept();
+    }
+
+    /* Solution or L exhausted: nobody keeps working on this L. */
+    for (int k = 0; k < g_nclients; ++k)
+        if (g_clients[k]->lease >= 0)
+        {
+            conn_send(g_clients[k]->conn.fd, "STOP\n");
+            g_clients[k]->lease = -1;
+        }
+    fflush(stdout);
+    free(leases);
+    mp_fanout_close(f);
+    return found;
+}
+
+/* Sends BYE to every worker and closes the listener. */
+void dist_shutdown(void)
+{
+    for (int k = 0; k < g_nclients; ++k)
+    {
+        conn_send(g_clients[k]->conn.fd, "BYE\n");
+        close(g_clients[k]->conn.fd);
+        free(g_clients[k]);
+    }
+    g_nclients = 0;
+    if (g_listen_fd >= 0)
+        close(g_listen_fd);
+    g_listen_fd = -1;
+    if (g_listen_path[0])
+        unlink(g_listen_path);
+    g_listen_path[0] = '\0';
+}
+
+/* ==================== Worker ==================== */
+
+typedef struct {
+    mp_fanout_t *f;
+    long long lo, hi;
+    bool found;
+    ruler_t res;
+    int wake;                   /* pipe: written once the lease is finished */
+} dist_job_t;
+
+static void *dist_job_main(void *arg)
+{
+    dist_job_t *j = (dist_job_t*)arg;
+    j->found = mp_fanout_solve(j->f, j->lo, j->hi, &j->res);
+    char b = 1;
+    while (write(j->wake, &b, 1) < 0 && errno == EINTR)
+        ;
+    return NULL;
+}
+
+/* ---------------------------------------------------------------------------
+ * dist_worker -- Connects to the coordinator (retrying for a while, so
+ * workers may start first) and runs leases until BYE or disconnect.
+ * --------------------------------------------------------------------------- */
+int dist_worker(const char *addr, bool verbose)
+{
+    dist_conn_t c;
+    memset(&c, 0, sizeof c);
+    c.fd = -1;
+    const struct timespec pause = { 0, 100 * 1000 * 1000 };
+    for (int t = 0; t < DIST_CONNECT_TRY && c.fd < 0; ++t)
+        if ((c.fd = dist_socket(addr, false)) < 0)
+            nanosleep(&pause, NULL);
+    if (c.fd < 0)
+    {
+        fprintf(stderr, "[DIST] cannot reach coordinator at %s: %s\n", addr, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    const int threads = wp_num_threads();
+    if (!conn_send(c.fd, "HELLO %d\n", threads))
+    {
+        close(c.fd);
+        return EXIT_FAILURE;
+    }
+    printf("[DIST] worker connected to %s (%d threads)\n", addr, threads);
+    fflush(stdout);
+
+    int wake[2];
+    if (pipe(wake) != 0)
+    {
+        close(c.fd);
+        return EXIT_FAILURE;
+    }
+    mp_fanout_t *f = NULL;
+    int fn = 0, fL = 0;
+    int status = EXIT_SUCCESS;
+    bool bye = false;
+    char line[DIST_LINE_MAX];
+    long long leases = 0;
+
+    while (!bye)
+    {
+        if (!conn_line(&c, line, sizeof line))
+        {
+            if (!conn_fill(&c))
+            {
+                fprintf(stderr, "[DIST] coordinator closed the connection\n");
+                status = EXIT_FAILURE;
+                break;
+            }
+            continue;
+        }
+        if (strcmp(line, "BYE") == 0)
+            break;
+        int n, L, depth, hints;
+        long long id, total, lo, hi;
+        if (sscanf(line, "LEASE %d %d %lld %d %lld %d %lld %lld",
+                   &n, &L, &id, &depth, &total, &hints, &lo, &hi) != 8)
+            continue;   /* STOP while idle, unknown messages */
+
+        /* Same (n, L, depth, hints) as the coordinator: same root list. */
+        if (!f || fn != n || fL != L || mp_fanout_depth(f) != depth ||
+            mp_fanout_hints(f) != (hints != 0))
+        {
+            mp_fanout_close(f);
+            f = mp_fanout_open(n, L, depth, 0, hints != 0, false);
+            fn = n;
+            fL = L;
+        }
+        if (!f || mp_fanout_total(f) != total || mp_fanout_depth(f) != depth ||
+            mp_fanout_hints(f) != (hints != 0))
+        {
+            fprintf(stderr, "[DIST] root list for n=%d L=%d differs from the coordinator's "
+                    "(different LUT/build?), leaving\n", n, L);
+            status = EXIT_FAILURE;
+            break;
+        }
+
+        dist_job_t job;
+        memset(&job, 0, sizeof job);
+        job.f = f;
+        job.lo = lo;
+        job.hi = hi;
+        job.wake = wake[1];
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, dist_job_main, &job) != 0)
+        {
+            status = EXIT_FAILURE;
+            break;
+        }
+        /* Wait for the lease to finish or for STOP/BYE. */
+        bool cancel = false;
+        for (;;)
+        {
+            struct pollfd pfd[2] = { { wake[0], POLLIN, 0 }, { c.fd, POLLIN, 0 } };
+            if (poll(pfd, cancel ? 1 : 2, -1) <= 0)
+                continue;
+            if (pfd[0].revents & POLLIN)
+            {
+                char b;
+                while (read(wake[0], &b, 1) < 0 && errno == EINTR)
+                    ;
+                break;
+            }
+            if (!conn_fill(&c))
+            {
+                cancel = bye = true;
+                status = EXIT_FAILURE;
+            }
+            /* Consume only up to STOP/BYE; a following LEASE stays queued. */
+            while (!cancel && conn_line(&c, line, sizeof line))
+            {
+                if (strcmp(line, "STOP") == 0)
+                    cancel = true;
+                else if (strcmp(line, "BYE") == 0)
+                    cancel = bye = true;
+            }
+            if (cancel)
+                __atomic_store_n(&g_wp_cancel, 1, __ATOMIC_RELEASE);
+        }
+        pthread_join(tid, NULL);
+        __atomic_store_n(&g_wp_cancel, 0, __ATOMIC_RELEASE);
+        ++leases;
+
+        bool sent;
+        if (job.found)
+        {
+            char msg[DIST_LINE_MAX];
+            int len = snprintf(msg, sizeof msg, "FOUND %d %lld", L, id);
+            for (int i = 0; i < n; ++i)
+                len += snprintf(msg + len, sizeof msg - (size_t)len, " %d", job.res.pos[i]);
+            sent = conn_send(c.fd, "%s\n", msg);
+            printf("[DIST] L=%d: lease %lld found a ruler\n", L, id);
+        }
+        else if (cancel)
+            sent = conn_send(c.fd, "ABORT %d %lld\n", L, id);
+        else
+            sent = conn_send(c.fd, "DONE %d %lld\n", L, id);
+        if (verbose && !job.found)
+            printf("[DIST] L=%d: lease %lld [%lld, %lld) %s\n", L, id, lo, hi,
+                   cancel ? "stopped" : "done");
+        fflush(stdout);
+        if (!sent && !bye)
+        {
+            /* A coordinator that is done sends BYE and closes at once. */
+            do
+                while (!bye && conn_line(&c, line, sizeof line))
+                    bye = (strcmp(line, "BYE") == 0);
+            while (!bye && conn_fill(&c));
+            if (!bye)
+            {
+                fprintf(stderr, "[DIST] coordinator closed the connection\n");
+                status = EXIT_FAILURE;
+            }
+            break;
+        }
+    }
+    printf("[DIST] worker finished after %lld leases\n", leases);
+    mp_fanout_close(f);
+    close(wake[0]);
+    close(wake[1]);
+    close(c.fd);
+    return status;
+}
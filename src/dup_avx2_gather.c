@@ -39,3 +39,53 @@ int test_any_dup8_avx2_gather(const uint64_t *bs, const int *dist8)
     }
     return 0;
 }
+
+/*
+ * Register-resident variants for narrow bitsets (live width 2 or 4 words,
+ * i.e. L < 256, see bs_words_for). The whole bitset sits in one ymm
+ * register, so the word lookup is a vpermd instead of a memory gather, and
+ * the bit is extracted with a per-lane variable shift (vpsrlvq).
+ *
+ * int test_any_dup8_avx2_w2(const uint64_t *bs, const int *dist8);
+ * int test_any_dup8_avx2_w4(const uint64_t *bs, const int *dist8);
+ * Distances must be < 128 (w2) or < 256 (w4).
+ */
+__attribute__((target("avx2")))
+static inline int dup8_in_register(__m256i vbs, const int *dist8)
+{
+    __m256i vdist = _mm256_loadu_si256((const __m256i *)dist8);
+    __m256i vword = _mm256_srli_epi32(vdist, 6);
+    __m256i vbit  = _mm256_and_si256(vdist, _mm256_set1_epi32(63));
+    __m256i one   = _mm256_set1_epi64x(1);
+
+    /* 64-bit word w is the 32-bit lane pair (2w, 2w+1). */
+    __m256i w_lo = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(vword));
+    __m256i w_hi = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(vword, 1));
+    __m256i p_lo = _mm256_slli_epi64(w_lo, 1);
+    __m256i p_hi = _mm256_slli_epi64(w_hi, 1);
+    p_lo = _mm256_or_si256(p_lo, _mm256_slli_epi64(_mm256_add_epi64(p_lo, one), 32));
+    p_hi = _mm256_or_si256(p_hi, _mm256_slli_epi64(_mm256_add_epi64(p_hi, one), 32));
+    __m256i words_lo = _mm256_permutevar8x32_epi32(vbs, p_lo);
+    __m256i words_hi = _mm256_permutevar8x32_epi32(vbs, p_hi);
+
+    __m256i b_lo = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(vbit));
+    __m256i b_hi = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(vbit, 1));
+    __m256i hit = _mm256_or_si256(_mm256_srlv_epi64(words_lo, b_lo),
+                                  _mm256_srlv_epi64(words_hi, b_hi));
+    return !_mm256_testz_si256(hit, one);
+}
+
+__attribute__((target("avx2")))
+int test_any_dup8_avx2_w2(const uint64_t *bs, const int *dist8)
+{
+    /* words {0,1,0,1}: indices 0..1 select the live pair */
+    __m256i vbs = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)bs));
+    return dup8_in_register(vbs, dist8);
+}
+
+__attribute__((target("avx2")))
+int test_any_dup8_avx2_w4(const uint64_t *bs, const int *dist8)
+{
+    __m256i vbs = _mm256_loadu_si256((const __m256i *)bs);
+    return dup8_in_register(vbs, dist8);
+}
@@ -38,3 +38,24 @@ int test_any_dup8_avx512(const uint64_t *bs, const int *dist8)
     /* test if any lane non-zero */
     return _mm512_test_epi64_mask(dup, dup) != 0;
 }
+
+/*
+ * Variant for a live width of up to 8 words (L < 512, see bs_words_for):
+ * the bitset is exactly one cache line and one zmm register, so the eight
+ * word lookups are a single vpermq instead of a gather.
+ * Distances must be < 512.
+ */
+__attribute__((target("avx512f,avx512vl,avx512dq")))
+int test_any_dup8_avx512_w8(const uint64_t *bs, const int *dist8)
+{
+    __m512i vbs = _mm512_loadu_si512((const void *)bs);
+    __m256i vdist32 = _mm256_loadu_si256((const __m256i *)dist8);
+
+    __m512i vword = _mm512_cvtepu32_epi64(_mm256_srli_epi32(vdist32, 6));
+    __m512i words = _mm512_permutexvar_epi64(vword, vbs);
+
+    __m512i vbit = _mm512_cvtepu32_epi64(_mm256_and_si256(vdist32, _mm256_set1_epi32(63)));
+    __m512i hit = _mm512_srlv_epi64(words, vbit);
+
+    return _mm512_test_epi64_mask(hit, _mm512_set1_epi64(1)) != 0;
+}
@@ -0,0 +1,149 @@
+/* ==========================================================================
+ * ESTIMATE.C — Knuth Subtree-Size Estimator (ETA and scheduling)
+ * ==========================================================================
+ *
+ * Knuth (1975): walk from the root of a search tree to a leaf, choosing a
+ * child uniformly at random at every node. If the nodes on the walk have
+ * c1, c2, ... children, then
+ *
+ *     1 + c1 + c1*c2 + c1*c2*c3 + ...
+ *
+ * is an unbiased estimate of the number of nodes in the tree. Averaging
+ * many walks reduces the (large) variance; estimating every root prefix of
+ * a fan-out separately and summing is a stratified sample of the whole
+ * tree and converges much faster than walks from the empty ruler.
+ *
+ * The children of a node are exactly the candidates the dfs() engine would
+ * commit: range from bounds_frame_range() (the same bounds as the engine),
+ * then the duplicate-distance test. Only committed nodes are counted (the
+ * last mark is never committed), which is what dfs_stack_t.nodes counts,
+ * so estimate and progress are in the same unit.
+ *
+ * Uses:
+ *   - the -vt heartbeat prints progress and an ETA against g_est_nodes;
+ *   - -mp without LUT hints dispatches the largest root prefixes first.
+ * Estimation only runs when g_estimate is set (by -vt), since for small
+ * orders it costs more than the search.
+ * ========================================================================== */
+
+#include "golomb.h"
+#include <string.h>
+
+bool g_estimate = false;
+double g_est_nodes = 0.0;
+unsigned long long g_nodes_done = 0;
+
+/* Bitset helpers (duplicated here for compilation-unit locality). */
+static inline void set_bit(uint64_t *bs, int idx) { bs[idx >> 6] |= 1ULL << (idx & 63); }
+static inline int test_bit(const uint64_t *bs, int idx) { return (bs[idx >> 6] >> (idx & 63)) & 1ULL; }
+
+/* xorshift64*: small, fast, reproducible per seed. */
+static inline uint64_t est_rand(uint64_t *s)
+{
+    uint64_t x = *s;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *s = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/* One random walk below the task's prefix. */
+static double est_probe(int n, int L, const dfs_task_t *t, uint64_t *rng)
+{
+    int pos[MAX_MARKS];
+    uint64_t dist_bs[BS_WORDS];
+    int cand[MAX_LEN_BITSET + 1];
+    const int bsw = bs_words_for(L);
+    memset(dist_bs, 0, (size_t)bsw * sizeof(uint64_t));
+    for (int j = 0; j < t->depth; ++j)
+    {
+        pos[j] = t->pos[j];
+        for (int i = 0; i < j; ++i)
+            set_bit(dist_bs, pos[j] - pos[i]);
+    }
+
+    double est = 0.0;
+    double weight = 1.0;
+    for (int d = t->depth; d < n - 1; ++d)
+    {
+        int lohi[2];
+        lohi[0] = pos[d - 1] + 1;
+        lohi[1] = L - (n - d - 1);
+        if (d == 1 && lohi[1] > L / 2)
+            lohi[1] = L / 2;          /* symmetry break */
+        if (d == t->depth)
+        {
+            if (lohi[0] < t->lo) lohi[0] = t->lo;
+            if (lohi[1] > t->hi) lohi[1] = t->hi;
+        }
+        if (lohi[0] > lohi[1] || !bounds_frame_range(d, n, L, pos, dist_bs, lohi))
+            break;
+
+        int c = 0;
+        for (int x = lohi[0]; x <= lohi[1]; ++x)
+        {
+            int i = d - 1;
+            while (i >= 0 && !test_bit(dist_bs, x - pos[i]))
+                --i;
+            if (i < 0)
+                cand[c++] = x;
+        }
+        if (c == 0)
+            break;
+        weight *= c;
+        est += weight;
+
+        int x = cand[est_rand(rng) % (uint64_t)c];
+        for (int i = 0; i < d; ++i)
+            set_bit(dist_bs, x - pos[i]);
+        pos[d] = x;
+    }
+    return est;
+}
+
+/* ---------------------------------------------------------------------------
+ * estimate_subtree -- Mean of `probes` Knuth walks: estimated number of
+ * nodes the engine commits below task t. Deterministic for a given seed.
+ * --------------------------------------------------------------------------- */
+double estimate_subtree(int n, int L, const dfs_task_t *t, int probes, uint64_t seed)
+{
+    if (n > MAX_MARKS || L > MAX_LEN_BITSET || t->depth < 1 || t->depth >= n || probes < 1)
+        return 0.0;
+    bounds_init();
+    uint64_t rng = (seed + 1) * 0x9E3779B97F4A7C15ULL;  /* nonzero for small seeds */
+    double sum = 0.0;
+    for (int p = 0; p < probes; ++p)
+        sum += est_probe(n, L, t, &rng);
+    return sum / probes;
+}
+
+/* ---------------------------------------------------------------------------
+ * estimate_roots -- Estimated node count of a whole fan-out (sum over the
+ * roots that need a search). The probe budget is spread over the roots; if
+ * there are more roots than EST_PROBE_BUDGET, an evenly strided sample of
+ * them is probed once each and scaled up. per_root (may be NULL) receives
+ * every root's estimate, 0 for roots that need no search; it is only
+ * filled when nroots <= EST_PROBE_BUDGET.
+ * --------------------------------------------------------------------------- */
+double estimate_roots(int n, int L, long long nroots, wp_root_fn root, void *ctx,
+                      double *per_root)
+{
+    if (nroots <= 0)
+        return 0.0;
+    long long stride = (nroots + EST_PROBE_BUDGET - 1) / EST_PROBE_BUDGET;
+    int probes = (int)(EST_PROBE_BUDGET / nroots);
+    if (probes < 1) probes = 1;
+    if (probes > 256) probes = 256;
+
+    double total = 0.0;
+    for (long long i = 0; i < nroots; i += stride)
+    {
+        dfs_task_t t;
+        double e = root(ctx, i, &t) ? estimate_subtree(n, L, &t, probes, (uint64_t)i) : 0.0;
+        if (stride == 1 && per_root)
+            per_root[i] = e;
+        total += e * (double)stride;
+    }
+    return total;
+}
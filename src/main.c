@@ -50,21 +50,44 @@ static void print_help(const char *prog_name)
     printf("  -v, --verbose      Enable verbose output during search.\n");
     printf("  -s, --single       Force single-threaded solver.\n");
     printf("  -mp                Use multi-threaded solver with static work division (default C path).\n");
-    printf("  -mpa               Use NASM assembler solver with LUT fast-lane (no checkpointing).\n");
+    printf("  -mpa               Use NASM assembler solver on the -mp prefix fan-out.\n");
     printf("  -d                 Use multi-threaded solver with dynamic OpenMP tasks.\n");
     printf("  -c                 Use 'creative' multi-threaded solver with dynamic scheduling.\n");
+    printf("  -sr                Use bit-parallel shift-register engine on the -mp prefix fan-out.\n");
     printf("  -p                 Use physics-based solver (Simulated Annealing). Implies -b.\n");
     printf("  -g                 Use evolutionary/genetic solver (Min-Conflicts). Implies -b.\n");
     printf("  -to                Use traditional optimized solver (endpoint-aware DFS). Implies -b.\n");
     printf("  -b                 Use best-known ruler length as a starting point heuristic.\n");
+    printf("  -bb                Single-pass branch-and-bound for the minimum length instead of\n"
+           "                     one search per L (with -s, -mp, -d, -c; -b bounds it by the LUT).\n");
     printf("  -e                 Enable SIMD (AVX2) optimizations where available.\n");
     printf("  -af                Use FASM assembler (unrolled scalar).\n");
     printf("  -an                Use NASM assembler (AVX2 gather).\n");
+    printf("  -ea <L>            Enumerate all rulers of length <L> (mirror images once) into the\n"
+           "                     -o file or out/GOL_n<n>_L<L>_all.txt; -s runs single-threaded.\n");
+    printf("  -bs                Print how many candidate nodes each LUT sub-ruler bound removed.\n");
+    printf("  -sw <k>            Speculative window (-mp): search L .. L+k-1 (k <= 8) in one pool,\n"
+           "                     smallest L first; a ruler cancels every larger L.\n");
+    printf("  -ho                Hint order: at every depth try the LUT ruler's gap first, the\n"
+           "                     candidates above it next, those below it last (dfs engine).\n");
+    printf("  -hk <k>            Fast lane: the root prefixes sharing the LUT ruler's first <k>\n"
+           "                     marks (default 3, the (second, third) pair; at most the root depth).\n");
+    printf("  -hw                Count cycles, instructions, branch and L1d misses per solver run\n"
+           "                     (perf_event_open); reports IPC and misses per node.\n");
     printf("  -t                 Run built-in benchmark suite for given <n>.\n");
     printf("  -o <file>          Write the found ruler to a file.\n");
-    printf("  -f <file>          Enable checkpointing (mp solver) and save/resume progress at <file>.\n");
+    printf("  -f <file>          Enable checkpointing (-mp, -mpa, -sr, -d, -c, -to) and save/resume at <file>.\n");
     printf("  -fi <sec>          Checkpoint flush interval in seconds (default 60).\n");
+    printf("  -fm                Keep the checkpoint bitset memory-mapped: flushes msync dirty\n"
+           "                     pages instead of rewriting the file, resume skips the bitset.\n");
+    printf("  -serve <addr>      Coordinate a distributed search: hand leases of -mp root prefixes\n"
+           "                     to -worker processes (addr: host:port, :port = loopback,\n"
+           "                     *:port = all interfaces, or unix:/path). No authentication:\n"
+           "                     any peer that can connect is trusted as a worker.\n");
+    printf("  -worker <addr>     Run leases for the coordinator at <addr> on -T threads.\n");
     printf("  -T <num>           Set number of threads for parallel solvers (default: all cores).\n");
+    printf("  -vt <min>          Heartbeat every <min> minutes (elapsed time, current L; with -mp,\n"
+           "                     -d, -c also progress and ETA from a sampled tree-size estimate).\n");
     printf("  --help             Display this help message and exit.\n");
 }
 
@@ -75,10 +98,13 @@ static double g_vt_sec = 0.0;
 
 /* Solver dispatch helper to avoid code duplication */
 typedef enum { SOLVER_SINGLE, SOLVER_MP, SOLVER_MPA, SOLVER_DYN, SOLVER_CREATIVE, 
-               SOLVER_PHYSICS, SOLVER_EVOLUTIONARY, SOLVER_TRAD_OPT } solver_type_t;
+               SOLVER_PHYSICS, SOLVER_EVOLUTIONARY, SOLVER_TRAD_OPT, SOLVER_SHIFT,
+               SOLVER_DIST } solver_type_t;
+
+static const char *g_serve_addr = NULL;  /* -serve: coordinator address */
 
 /* Solver dispatch helper including ASM -mpa */
-static bool run_solver(solver_type_t type, int n, int L, ruler_t *result, bool verbose)
+static bool dispatch_solver(solver_type_t type, int n, int L, ruler_t *result, bool verbose)
 {
     extern bool solve_golomb_mt_asm(int, int, ruler_t*, int);
     extern bool solve_golomb_physics(int, int, ruler_t*, bool);
@@ -89,6 +115,8 @@ static bool run_solver(solver_type_t type, int n, int L, ruler_t *result, bool v
         case SOLVER_DYN:          return solve_golomb_mt_dyn(n, L, result, verbose);
         case SOLVER_MPA:          return solve_golomb_mt_asm(n, L, result, verbose ? 1 : 0);
         case SOLVER_MP:           return solve_golomb_mt(n, L, result, verbose);
+        case SOLVER_SHIFT:        return solve_golomb_shift(n, L, result, verbose);
+        case SOLVER_DIST:         return dist_coordinate(g_serve_addr, n, L, result, verbose);
         case SOLVER_PHYSICS:      return solve_golomb_physics(n, L, result, verbose);
         case SOLVER_EVOLUTIONARY: return solve_golomb_evolutionary(n, L, result, verbose);
         case SOLVER_TRAD_OPT:     return solve_golomb_traditional_opt(n, L, result, verbose);
@@ -97,13 +125,58 @@ static bool run_solver(solver_type_t type, int n, int L, ruler_t *result, bool v
     }
 }
 
-/* Checkpointing globals (declared in golomb.h) */
-const char *g_cp_path = NULL;
-int g_cp_interval_sec = 60; /* default 60s */
+/* Nodes searched so far, for the -hw per-node figures: every engine node
+ * with the STATS build, otherwise only the pool solvers count them. */
+static double search_nodes(void)
+{
+#ifdef GOLOMB_STATS
+    search_stats_t s;
+    double t = 0.0;
+    stats_sum(&s);
+    for (int d = 0; d < MAX_MARKS; ++d)
+        t += (double)s.nodes[d];
+    return t;
+#else
+    return (double)__atomic_load_n(&g_nodes_done, __ATOMIC_RELAXED);
+#endif
+}
 
+/* One solver run over L .. L+nlens-1 (nlens > 1: -sw window, -mp only),
+ * bracketed by the hardware counters with -hw. */
+static bool run_solver(solver_type_t type, int n, int L, int nlens, ruler_t *result, bool verbose)
+{
+    if (!g_perf)
+        return (nlens > 1) ? solve_golomb_window_mt(n, L, nlens, result, verbose)
+                           : dispatch_solver(type, n, L, result, verbose);
+    __atomic_store_n(&g_nodes_done, 0, __ATOMIC_RELAXED);
+    double before = search_nodes();
+    perf_begin();
+    bool ok = (nlens > 1) ? solve_golomb_window_mt(n, L, nlens, result, verbose)
+                          : dispatch_solver(type, n, L, result, verbose);
+    perf_end(search_nodes() - before);
+    return ok;
+}
+
+/* Solvers that write -f checkpoints (all exact, so a finished file proves
+ * its L infeasible). */
+static bool solver_checkpoints(solver_type_t t)
+{
+    switch (t)
+    {
+        case SOLVER_MP: case SOLVER_MPA: case SOLVER_SHIFT: case SOLVER_DYN:
+        case SOLVER_CREATIVE: case SOLVER_TRAD_OPT: case SOLVER_DIST:
+            return true;
+        default:
+            return false;
+    }
+}
 
 static void *heartbeat_thread(void *arg)
 {
+    /* Start of the current search (new L, or node counter restarted). */
+    int seen_L = -1;
+    unsigned long long seen_done = 0;
+    double search_t0 = 0.0;
     while (!g_done)
     {
         struct timespec ts_now;
@@ -112,11 +185,43 @@ static void *heartbeat_thread(void *arg)
         char tbuf[32];
         format_elapsed(since, tbuf, sizeof tbuf);
         int L = g_current_L;
-        if (L >= 0)
+        int bb = __atomic_load_n(&g_bb_best, __ATOMIC_RELAXED);
+        unsigned long long done = __atomic_load_n(&g_nodes_done, __ATOMIC_RELAXED);
+        double est = g_est_nodes;
+        if (L != seen_L || done < seen_done)
+        {
+            seen_L = L;
+            search_t0 = since;
+        }
+        seen_done = done;
+        if (bb > 0)
+            fprintf(stdout, "[VT] %s elapsed – B&B bound L<%d\n", tbuf, bb);
+        else if (L >= 0 && est > 0.0 && done > 0 && since > search_t0)
+        {
+            /* Knuth estimate of this L (estimate.c) against the pool's
+             * node count; the estimate is noisy, so cap at 99.9%. */
+            double frac = (double)done / est;
+            if (frac > 0.999) frac = 0.999;
+            double eta = (since - search_t0) * (1.0 - frac) / frac;
+            char ebuf[32];
+            format_elapsed(eta, ebuf, sizeof ebuf);
+            fprintf(stdout, "[VT] %s elapsed – current L=%d – %.3g of ~%.3g nodes (%.1f%%), ETA %s\n",
+                    tbuf, L, (double)done, est, 100.0 * frac, ebuf);
+        }
+        else if (L >= 0)
             fprintf(stdout, "[VT] %s elapsed – current L=%d\n", tbuf, L);
+#ifdef GOLOMB_STATS
+        stats_tick(stdout, since);
+#endif
         fflush(stdout);
-        struct timespec req = {(time_t)g_vt_sec, (long)((g_vt_sec - (time_t)g_vt_sec) * 1e9)};
-        nanosleep(&req, NULL);
+        /* Sleep in short steps so the final join (and with it the measured
+         * run time) does not wait out a whole interval. */
+        for (double left = g_vt_sec; left > 0.0 && !g_done; left -= 0.05)
+        {
+            double step = (left < 0.05) ? left : 0.05;
+            struct timespec req = {0, (long)(step * 1e9)};
+            nanosleep(&req, NULL);
+        }
     }
     return NULL;
 }
@@ -158,6 +263,10 @@ int main(int argc, char **argv)
     pthread_t hb_thread;
     bool use_heuristic_start = false;
     bool use_creative = false;
+    bool use_shift = false;
+    bool use_bb = false;
+    int window = 1;            /* -sw <k>: L values searched at once */
+    int enum_len = 0;          /* -ea <L>: enumerate instead of search */
     bool use_physics = false;
     bool use_evolutionary = false;
     bool use_trad_opt = false;
@@ -165,6 +274,7 @@ int main(int argc, char **argv)
     bool use_asm_fasm = false; /* -af flag: FASM unrolled scalar */
     bool use_asm_nasm = false; /* -an flag: NASM AVX2 gather */
     char *output_file = NULL;
+    const char *worker_addr = NULL;  /* -worker: run leases for a coordinator */
     bool force_single_thread = false;
     /* parse optional flags */
     for (int i = 2; i < argc; ++i)
@@ -193,6 +303,18 @@ int main(int argc, char **argv)
         {
             use_mp = true;
         }
+        else if (strcmp(argv[i], "-serve") == 0 || strcmp(argv[i], "-worker") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                fprintf(stderr, "Error: %s option requires an address.\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+            if (argv[i][1] == 's')
+                g_serve_addr = argv[++i];
+            else
+                worker_addr = argv[++i];
+        }
         else if (strcmp(argv[i], "-mpa") == 0)
         {
             use_mpa = true;
@@ -213,6 +335,31 @@ int main(int argc, char **argv)
         {
             use_creative = true;
         }
+        else if (strcmp(argv[i], "-bb") == 0)
+        {
+            use_bb = true;
+        }
+        else if (strcmp(argv[i], "-ea") == 0)
+        {
+            if (i + 1 < argc)
+            {
+                enum_len = atoi(argv[++i]);
+                if (enum_len < 1 || enum_len > MAX_LEN_BITSET)
+                {
+                    fprintf(stderr, "Error: -ea length must be between 1 and %d.\n", MAX_LEN_BITSET);
+                    return EXIT_FAILURE;
+                }
+            }
+            else
+            {
+                fprintf(stderr, "Error: -ea option requires a length.\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "-sr") == 0)
+        {
+            use_shift = true;
+        }
         else if (strcmp(argv[i], "-p") == 0)
         {
             use_physics = true;
@@ -233,6 +380,7 @@ int main(int argc, char **argv)
                 g_vt_sec = vt_sec;
                 if (vt_sec < 0.01)
                     vt_sec = 0.0;
+                g_estimate = (vt_sec > 0.0);  /* heartbeat shows an ETA */
             }
             else
             {
@@ -252,6 +400,43 @@ int main(int argc, char **argv)
         {
             use_asm_nasm = true;
         }
+        else if (strcmp(argv[i], "-bs") == 0)
+        {
+            g_bound_stats = true;
+        }
+        else if (strcmp(argv[i], "-sw") == 0)
+        {
+            if (i + 1 < argc && atoi(argv[i + 1]) >= 1 && atoi(argv[i + 1]) <= L_WINDOW_MAX)
+            {
+                window = atoi(argv[++i]);
+            }
+            else
+            {
+                fprintf(stderr, "Error: -sw option requires a window of 1..%d L values.\n",
+                        L_WINDOW_MAX);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "-ho") == 0)
+        {
+            g_hint_order = true;
+        }
+        else if (strcmp(argv[i], "-hk") == 0)
+        {
+            if (i + 1 < argc && atoi(argv[i + 1]) >= 2)
+            {
+                g_lane_marks = atoi(argv[++i]);
+            }
+            else
+            {
+                fprintf(stderr, "Error: -hk option requires a mark count >= 2.\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "-hw") == 0)
+        {
+            g_perf = true;
+        }
         else if (strcmp(argv[i], "-t") == 0)
         {
             run_tests = true;
@@ -281,6 +466,10 @@ int main(int argc, char **argv)
                 return EXIT_FAILURE;
             }
         }
+        else if (strcmp(argv[i], "-fm") == 0)
+        {
+            g_cp_mmap = true;
+        }
         else if (strcmp(argv[i], "-T") == 0)
         {
             if (i + 1 < argc)
@@ -308,6 +497,10 @@ int main(int argc, char **argv)
         return 0;
     }
 
+    /* Distributed worker: the leases carry n and L, no L loop here. */
+    if (worker_addr)
+        return dist_worker(worker_addr, verbose);
+
     const ruler_t *ref = lut_lookup_by_marks(n);
 
     ruler_t result;
@@ -319,32 +512,76 @@ extern int test_any_dup8_avx512(const uint64_t *, const int *) __attribute__((we
 extern int test_any_dup8_avx2_gather(const uint64_t *, const int *) __attribute__((weak));
 extern int test_any_dup8_avx2_asm(const uint64_t *, const int *) __attribute__((weak));
 extern int test_any_dup8_avx2_nasm(const uint64_t *, const int *) __attribute__((weak));
-    /* Default-enable SIMD if compiled with AVX2/AVX512, or when -e is passed */
+    /* Default-enable SIMD if the CPU has AVX2 (cpuid), or when -e is passed */
     g_use_asm_fasm = use_asm_fasm;
     g_use_asm_nasm = use_asm_nasm;
-#if defined(__AVX512F__) || defined(__AVX2__)
-    g_use_simd = true;
-#else
-    g_use_simd = false;
-#endif
+    g_use_simd = cpu_isa() >= ISA_AVX2;
     if (use_simd) g_use_simd = true;
-        /* Ensure OpenMP cancellation is enabled unless the user already set it */
-        if (!getenv("OMP_CANCELLATION"))
+        /* Only the -sr/-mpa OpenMP fan-outs still use task cancellation
+         * (-mp, -d and -c stop through the work-stealing pool). */
+        if ((use_shift || use_mpa) && !getenv("OMP_CANCELLATION"))
             setenv("OMP_CANCELLATION", "TRUE", 1);
         /* Inform user which distance duplicate implementation will be used
-         * (must match dispatch order in solver.c test_any_dup8) */
-        const char *dup_impl = "scalar (intrinsic)";
+         * (must match dfs_select in solver.c) */
+        const char *dup_impl = "scalar";
         if (g_use_asm_fasm && test_any_dup8_avx2_asm)
             dup_impl = "FASM (AVX2 gather asm)";
         else if (g_use_asm_nasm && test_any_dup8_avx2_nasm)
             dup_impl = "NASM (AVX2 gather asm)";
-        else if (g_use_simd && test_any_dup8_avx512 && getenv("GOLOMB_USE_AVX512"))
-            dup_impl = "AVX-512 gather";
-        else if (g_use_simd && test_any_dup8_avx2_gather)
-            dup_impl = "AVX2 gather (C)";
-        else if (g_use_simd)
+        else if (g_use_simd && test_any_dup8_avx512 && getenv("GOLOMB_USE_AVX512") &&
+                 cpu_isa() >= ISA_AVX512)
+            dup_impl = "AVX-512 gather, in-register for L < 512";
+        else if (g_use_simd && test_any_dup8_avx2_gather && cpu_isa() >= ISA_AVX2)
+            dup_impl = "AVX2 gather (C), in-register for L < 256";
+        else if (g_use_simd && cpu_isa() >= ISA_AVX2)
             dup_impl = "AVX2 intrinsics";
         printf("[Info] Distance duplicate test implementation: %s\n", dup_impl);
+        if (verbose)
+            printf("[Info] CPU: %s, per-n DFS kernels: %s\n",
+                   cpu_isa_name(cpu_isa()), dfs_kernels_isa());
+
+    /* Enumeration mode: all rulers of one length, then exit. */
+    if (enum_len > 0)
+    {
+        char ename[128];
+        if (output_file != NULL)
+        {
+            strncpy(ename, output_file, sizeof(ename) - 1);
+            ename[sizeof(ename) - 1] = '\0';
+        }
+        else
+        {
+            if (mkdir("out", 0755) == -1 && errno != EEXIST)
+                perror("mkdir out");
+            snprintf(ename, sizeof ename, "out/GOL_n%d_L%d_all.txt", n, enum_len);
+        }
+        FILE *efp = fopen(ename, "w");
+        if (!efp)
+        {
+            perror("fopen");
+            return EXIT_FAILURE;
+        }
+        long long cnt = enumerate_golomb(n, enum_len, efp, !force_single_thread);
+        fclose(efp);
+        if (cnt < 0)
+        {
+            fprintf(stderr, "Enumeration failed (out of memory).\n");
+            return EXIT_FAILURE;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &ts_end);
+        char ebuf[32];
+        format_elapsed((ts_end.tv_sec - ts_start.tv_sec) + (ts_end.tv_nsec - ts_start.tv_nsec) / 1e9,
+                       ebuf, sizeof ebuf);
+        printf("[Enum] n=%d L=%d: %lld rulers (mirror images counted once) -> %s\n",
+               n, enum_len, cnt, ename);
+        printf("Elapsed time: %s\n", ebuf);
+        if (g_bound_stats)
+            bounds_report(stdout);
+#ifdef GOLOMB_STATS
+        stats_report(stdout, (ts_end.tv_sec - ts_start.tv_sec) + (ts_end.tv_nsec - ts_start.tv_nsec) / 1e9);
+#endif
+        return EXIT_SUCCESS;
+    }
 
     bool solved = false;
     bool compared = false;
@@ -355,13 +592,30 @@ extern int test_any_dup8_avx2_nasm(const uint64_t *, const int *) __attribute__(
     if (use_physics)        solver_type = SOLVER_PHYSICS;
     else if (use_evolutionary) solver_type = SOLVER_EVOLUTIONARY;
     else if (use_trad_opt)  solver_type = SOLVER_TRAD_OPT;
+    else if (g_serve_addr)  solver_type = SOLVER_DIST;
     else if (!force_single_thread) {
         if (use_creative)       solver_type = SOLVER_CREATIVE;
+        else if (use_shift)     solver_type = SOLVER_SHIFT;
         else if (use_mt_dyn)    solver_type = SOLVER_DYN;
         else if (use_mpa)       solver_type = SOLVER_MPA;
         else if (use_mp)        solver_type = SOLVER_MP;
     }
 
+    /* -bb runs on the dfs() engine: single-threaded or with the -mp fan-out. */
+    if (use_bb && solver_type != SOLVER_SINGLE && solver_type != SOLVER_MP &&
+        solver_type != SOLVER_DYN && solver_type != SOLVER_CREATIVE)
+    {
+        printf("[Info] -bb is not available for this solver; searching L by L.\n");
+        use_bb = false;
+    }
+
+    /* -sw: the window runs on the -mp pool; a checkpoint covers one L. */
+    if (window > 1 && (solver_type != SOLVER_MP || (g_cp_path && *g_cp_path)))
+    {
+        printf("[Info] -sw needs -mp without -f; searching L by L.\n");
+        window = 1;
+    }
+
     /* -g, -p, -a, -to implizieren -b (starten beim LUT-Wert). */
     if (use_physics || use_evolutionary || use_trad_opt)
         use_heuristic_start = true;
@@ -389,10 +643,41 @@ extern int test_any_dup8_avx2_nasm(const uint64_t *, const int *) __attribute__(
     if (vt_sec > 0.0)
         pthread_create(&hb_thread, NULL, heartbeat_thread, NULL);
 
-    /* Pre-check: if LUT exists and -b is NOT used, try the LUT length once */
-    if (ref && !use_heuristic_start)
+    /* Branch-and-bound: one search with a shrinking bound replaces the L
+     * loop. With -b the LUT length bounds it from above. */
+    if (use_bb)
     {
-        if (run_solver(solver_type, n, ref->length, &result, verbose))
+        int upper = (use_heuristic_start && ref) ? ref->length + 1 : MAX_LEN_BITSET + 1;
+        __atomic_store_n(&g_nodes_done, 0, __ATOMIC_RELAXED);
+        double before = search_nodes();
+        perf_begin();
+        solved = solve_golomb_bb(n, upper, &result, verbose, solver_type != SOLVER_SINGLE);
+        perf_end(search_nodes() - before);
+    }
+
+    /* -f: a checkpoint left by an earlier run of this sweep shows that
+     * sweep_lo .. L-1 have no ruler; continue at its L (at L + 1 if L is
+     * done as well) instead of at the start. */
+    int sweep_start = target_len_start;
+    int sweep_lo = target_len_start;
+    cp_sweep_t sw;
+    if (!use_bb && solver_checkpoints(solver_type) &&
+        cp_sweep_peek(g_cp_path, n, &sw) &&
+        sw.sweep_lo > 0 && sw.sweep_lo <= target_len_start && sw.L >= target_len_start)
+    {
+        sweep_lo = sw.sweep_lo;
+        sweep_start = sw.complete ? sw.L + 1 : sw.L;
+        if (sweep_start > target_len_start)
+            printf("[CP] %s: L=%d..%d already searched without a ruler, resuming at L=%d\n",
+                   g_cp_path, sw.sweep_lo, sweep_start - 1, sweep_start);
+    }
+
+    /* Pre-check: if LUT exists and -b is NOT used, try the LUT length once
+     * (not when resuming a sweep: it would replace the sweep's checkpoint). */
+    if (!use_bb && ref && !use_heuristic_start && sweep_start == target_len_start)
+    {
+        g_current_L = ref->length;
+        if (run_solver(solver_type, n, ref->length, 1, &result, verbose))
             solved = true;
     }
 
@@ -401,15 +686,19 @@ extern int test_any_dup8_avx2_nasm(const uint64_t *, const int *) __attribute__(
      * und suboptimale Lineale finden. */
     bool heuristic_only = (use_physics || use_evolutionary);
 
-    for (int L = target_len_start; !solved && L <= MAX_LEN_BITSET; ++L)
+    g_cp_sweep_lo = sweep_lo;
+    for (int L = sweep_start; !use_bb && !solved && L <= MAX_LEN_BITSET; L += window)
     {
-        if (run_solver(solver_type, n, L, &result, verbose))
+        g_current_L = L;
+        if (run_solver(solver_type, n, L, window, &result, verbose))
         {
             solved = true;
             break;
         }
         if (heuristic_only) break;  /* nur einen L-Wert versuchen */
     }
+    if (solver_type == SOLVER_DIST)
+        dist_shutdown();
 
     if (ref)
     {
@@ -439,6 +728,12 @@ extern int test_any_dup8_avx2_nasm(const uint64_t *, const int *) __attribute__(
     printf("Found ruler: ");
     print_ruler(&result);
     printf("Elapsed time: %s\n", tbuf);
+    if (g_bound_stats)
+        bounds_report(stdout);
+#ifdef GOLOMB_STATS
+    stats_report(stdout, elapsed);
+#endif
+    perf_report(stdout);
 
     /* compute all pairwise distances */
     int dist[(MAX_MARKS * (MAX_MARKS - 1)) / 2];
@@ -473,7 +768,12 @@ extern int test_any_dup8_avx2_nasm(const uint64_t *, const int *) __attribute__(
     char fsuffix[64] = "";
 
     // Solver type flags (mutually exclusive, reflects solver choice)
-    if (force_single_thread)
+    if (g_serve_addr)
+    {
+        strcat(opts, "-serve ");
+        strcat(fsuffix, "_dist");
+    }
+    else if (force_single_thread)
     {
         strcat(opts, "-s ");
         strcat(fsuffix, "_s");
@@ -493,6 +793,11 @@ extern int test_any_dup8_avx2_nasm(const uint64_t *, const int *) __attribute__(
         strcat(opts, "-c ");
         strcat(fsuffix, "_c");
     }
+    else if (use_shift)
+    {
+        strcat(opts, "-sr ");
+        strcat(fsuffix, "_sr");
+    }
     else if (use_mt_dyn)
     {
         strcat(opts, "-d ");
@@ -510,6 +815,11 @@ extern int test_any_dup8_avx2_nasm(const uint64_t *, const int *) __attribute__(
     }
 
     // Additive flags
+    if (use_bb)
+    {
+        strcat(opts, "-bb ");
+        strcat(fsuffix, "_bb");
+    }
     if (use_heuristic_start)
     {
         strcat(opts, "-b ");
@@ -573,6 +883,10 @@ extern int test_any_dup8_avx2_nasm(const uint64_t *, const int *) __attribute__(
         fprintf(fp, "\nseconds=%.6f\ntime=%s\noptions=%s\n", elapsed, tbuf, optlen ? opts : "none");
         if (compared)
             fprintf(fp, "optimal=%s\n", optimal ? "yes" : "no");
+#ifdef GOLOMB_STATS
+        stats_write(fp, elapsed);
+#endif
+        perf_write(fp);
         fclose(fp);
     }
     else
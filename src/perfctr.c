@@ -0,0 +1,236 @@
+/* ==========================================================================
+ * PERFCTR.C — Hardware Performance Counters around Solver Runs (-hw)
+ * ==========================================================================
+ *
+ * Wall clock alone does not show why one duplicate-check backend (-af, -an,
+ * AVX2 gather, GOLOMB_USE_AVX512) beats another. With -hw every solver run
+ * is bracketed by perf_begin()/perf_end(), which count
+ *
+ *   cycles, instructions, branch misses, L1d read misses
+ *
+ * through perf_event_open(2), user space only. Each thread that exists when
+ * the run starts (main thread, OpenMP pool) gets its own events; threads
+ * created during the run (the work-stealing pool) inherit the events of
+ * their creator, and their counts are folded into it when they exit. The
+ * counts of all runs are summed and reported as IPC and per-node figures
+ * next to the [Stats] output.
+ *
+ * Multiplexing: if the PMU has fewer counters than requested, the kernel
+ * time-shares them; values are scaled by time_enabled / time_running.
+ *
+ * Degradation: if perf events are not permitted (perf_event_paranoid,
+ * seccomp in containers, no PMU in a VM) or not supported, a single note is
+ * printed and -hw turns itself off; single events that fail are reported as
+ * n/a. The search itself is never affected.
+ * ========================================================================== */
+
+#define _GNU_SOURCE /* syscall() */
+#include "golomb.h"
+#include <string.h>
+
+bool g_perf = false;
+
+enum { PC_CYCLES, PC_INSTR, PC_BRANCH_MISS, PC_L1D_MISS, PC_KINDS };
+
+static const char *const g_pc_names[PC_KINDS] = {
+    "cycles", "instructions", "branch_misses", "l1d_misses"
+};
+
+static double g_pc_total[PC_KINDS];
+static bool g_pc_seen[PC_KINDS];        /* counted in at least one run */
+static double g_pc_nodes;
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+
+#define PC_MAX_THREADS 512
+
+static int g_pc_fd[PC_MAX_THREADS][PC_KINDS];
+static int g_pc_threads;
+
+static int pc_open(pid_t tid, int kind)
+{
+    struct perf_event_attr a;
+    memset(&a, 0, sizeof a);
+    a.size = sizeof a;
+    switch (kind)
+    {
+        case PC_CYCLES:
+            a.type = PERF_TYPE_HARDWARE;
+            a.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PC_INSTR:
+            a.type = PERF_TYPE_HARDWARE;
+            a.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PC_BRANCH_MISS:
+            a.type = PERF_TYPE_HARDWARE;
+            a.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            a.type = PERF_TYPE_HW_CACHE;
+            a.config = PERF_COUNT_HW_CACHE_L1D |
+                       (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+    }
+    a.disabled = 1;
+    a.inherit = 1;
+    a.exclude_kernel = 1;
+    a.exclude_hv = 1;
+    a.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &a, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+/* ---------------------------------------------------------------------------
+ * perf_begin -- Open and start the counters on every thread of the process.
+ * Returns false (and clears g_perf after one note on stderr) if no event
+ * could be opened at all.
+ * --------------------------------------------------------------------------- */
+bool perf_begin(void)
+{
+    g_pc_threads = 0;
+    if (!g_perf)
+        return false;
+    DIR *dir = opendir("/proc/self/task");
+    if (!dir)
+    {
+        fprintf(stderr, "[Perf] /proc/self/task not readable; -hw disabled.\n");
+        g_perf = false;
+        return false;
+    }
+    int err = 0;
+    bool any = false;
+    struct dirent *e;
+    while ((e = readdir(dir)) && g_pc_threads < PC_MAX_THREADS)
+    {
+        if (e->d_name[0] < '0' || e->d_name[0] > '9')
+            continue;
+        pid_t tid = (pid_t)atoi(e->d_name);
+        int *fd = g_pc_fd[g_pc_threads++];
+        for (int k = 0; k < PC_KINDS; ++k)
+        {
+            fd[k] = pc_open(tid, k);
+            if (fd[k] < 0)
+                err = errno;
+            else
+                any = true;
+        }
+    }
+    closedir(dir);
+
+    if (!any)
+    {
+        fprintf(stderr, "[Perf] hardware counters unavailable (%s)%s; -hw disabled.\n",
+                strerror(err), (err == EACCES || err == EPERM)
+                    ? ", see /proc/sys/kernel/perf_event_paranoid" : "");
+        g_pc_threads = 0;
+        g_perf = false;
+        return false;
+    }
+    for (int t = 0; t < g_pc_threads; ++t)
+        for (int k = 0; k < PC_KINDS; ++k)
+            if (g_pc_fd[t][k] >= 0)
+                ioctl(g_pc_fd[t][k], PERF_EVENT_IOC_ENABLE, 0);
+    return true;
+}
+
+/* ---------------------------------------------------------------------------
+ * perf_end -- Stop the counters opened by perf_begin, add them to the run
+ * totals together with the `nodes` the run searched (0 if unknown).
+ * --------------------------------------------------------------------------- */
+void perf_end(double nodes)
+{
+    if (g_pc_threads == 0)
+        return;
+    for (int t = 0; t < g_pc_threads; ++t)
+        for (int k = 0; k < PC_KINDS; ++k)
+            if (g_pc_fd[t][k] >= 0)
+                ioctl(g_pc_fd[t][k], PERF_EVENT_IOC_DISABLE, 0);
+    for (int t = 0; t < g_pc_threads; ++t)
+    {
+        for (int k = 0; k < PC_KINDS; ++k)
+        {
+            int fd = g_pc_fd[t][k];
+            if (fd < 0)
+                continue;
+            uint64_t v[3]; /* value, time_enabled, time_running */
+            if (read(fd, v, sizeof v) == (ssize_t)sizeof v && v[2] > 0)
+            {
+                g_pc_total[k] += (double)v[0] * ((double)v[1] / (double)v[2]);
+                g_pc_seen[k] = true;
+            }
+            close(fd);
+        }
+    }
+    g_pc_threads = 0;
+    g_pc_nodes += nodes;
+}
+
+#else /* !__linux__ */
+
+bool perf_begin(void)
+{
+    if (g_perf)
+        fprintf(stderr, "[Perf] perf_event_open is Linux-only; -hw disabled.\n");
+    g_perf = false;
+    return false;
+}
+
+void perf_end(double nodes)
+{
+    (void)nodes;
+}
+
+#endif
+
+/* Prints the totals of all runs: raw counts, IPC and per-node figures. */
+void perf_report(FILE *fp)
+{
+    bool any = false;
+    for (int k = 0; k < PC_KINDS; ++k)
+        any |= g_pc_seen[k];
+    if (!any)
+        return;
+    fprintf(fp, "[Perf]");
+    for (int k = 0; k < PC_KINDS; ++k)
+    {
+        if (g_pc_seen[k])
+            fprintf(fp, " %s=%.4g", g_pc_names[k], g_pc_total[k]);
+        else
+            fprintf(fp, " %s=n/a", g_pc_names[k]);
+    }
+    if (g_pc_seen[PC_CYCLES] && g_pc_seen[PC_INSTR] && g_pc_total[PC_CYCLES] > 0.0)
+        fprintf(fp, " IPC=%.2f", g_pc_total[PC_INSTR] / g_pc_total[PC_CYCLES]);
+    fprintf(fp, "\n");
+    if (g_pc_nodes > 0.0)
+    {
+        fprintf(fp, "[Perf] per node (%.0f nodes):", g_pc_nodes);
+        for (int k = 0; k < PC_KINDS; ++k)
+            if (g_pc_seen[k])
+                fprintf(fp, " %s=%.3f", g_pc_names[k], g_pc_total[k] / g_pc_nodes);
+        fprintf(fp, "\n");
+    }
+}
+
+/* Same as key=value lines for the result file. */
+void perf_write(FILE *fp)
+{
+    for (int k = 0; k < PC_KINDS; ++k)
+    {
+        if (!g_pc_seen[k])
+            continue;
+        fprintf(fp, "hw_%s=%.0f\n", g_pc_names[k], g_pc_total[k]);
+        if (g_pc_nodes > 0.0)
+            fprintf(fp, "hw_%s_per_node=%.4f\n", g_pc_names[k], g_pc_total[k] / g_pc_nodes);
+    }
+    if (g_pc_seen[PC_CYCLES] && g_pc_seen[PC_INSTR] && g_pc_total[PC_CYCLES] > 0.0)
+        fprintf(fp, "hw_ipc=%.3f\n", g_pc_total[PC_INSTR] / g_pc_total[PC_CYCLES]);
+}
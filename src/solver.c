@@ -3,15 +3,18 @@
  * ==========================================================================
  *
  * This file contains:
- *   1. The standard recursive DFS solver (solve_golomb / dfs) that places
- *      marks left-to-right and backtracks on duplicate distances.
+ *   1. The standard DFS solver (solve_golomb / dfs) that places marks
+ *      left-to-right and backtracks on duplicate distances, running on an
+ *      explicit, suspendable frame stack (dfs_stack_t) instead of recursion.
  *   2. The multi-threaded static solver (solve_golomb_mt / -mp) that
- *      parallelizes over the first two decision levels (second, third mark)
- *      using OpenMP taskloop with optional LUT-guided candidate ordering.
- *   3. The dynamic task solver (solve_golomb_mt_dyn / -d) using recursive
- *      OpenMP tasks with cancellation.
- *   4. Checkpointing support for the -mp solver (binary bitset of processed
- *      candidate pairs, periodic flushing).
+ *      parallelizes over prefixes of 3..6 marks (adaptive depth)
+ *      on the work-stealing pool (workpool.c) with optional LUT-guided
+ *      candidate ordering.
+ *   3. The dynamic task solver (solve_golomb_mt_dyn / -d): the same pairs,
+ *      unordered, on the same pool.
+ *   4. Checkpointing of the prefix fan-out (-mp, -sr, -mpa, -d): the
+ *      done-bitset of the root prefixes plus snapshots of the pool's
+ *      in-flight subtrees (file format in checkpoint.c).
  *   5. SIMD distance-checking helpers (AVX2 gather, AVX-512, ASM backends).
  *
  * Distance tracking:
@@ -20,6 +23,7 @@
  *   This allows O(1) duplicate detection per distance.
  * ========================================================================== */
 
+#define _POSIX_C_SOURCE 200809L   /* clock_gettime */
 #include "golomb.h"
 #include <string.h>
 #include <immintrin.h> /* AVX2 intrinsics */
@@ -28,75 +32,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <errno.h>
-
-/* ==================== Checkpointing helpers ==================== */
-typedef struct {
-    char magic[4];      /* "GRCP" */
-    uint32_t version;   /* 1 */
-    uint32_t n;
-    uint32_t L;
-    uint64_t total;
-    uint32_t hint_s;
-    uint32_t hint_t;
-    uint32_t hint_used; /* 0/1 */
-} cp_header_t;
-
-#ifdef _OPENMP
-static int cp_load_file(const char *path,
-                        int n,
-                        int target_length,
-                        long long total,
-                        int hint_s,
-                        int hint_t,
-                        int hint_used,
-                        uint32_t *done_words,
-                        size_t words)
-{
-    FILE *fp = fopen(path, "rb");
-    if (!fp) return 0;
-    cp_header_t h;
-    size_t r = fread(&h, 1, sizeof h, fp);
-    if (r != sizeof h || memcmp(h.magic, "GRCP", 4) != 0 || h.version != 1) { fclose(fp); return 0; }
-    if (h.n != (uint32_t)n || h.L != (uint32_t)target_length || h.total != (uint64_t)total) { fclose(fp); return 0; }
-    if (h.hint_s != (uint32_t)hint_s || h.hint_t != (uint32_t)hint_t || h.hint_used != (uint32_t)hint_used) { fclose(fp); return 0; }
-    size_t want = words * sizeof(uint32_t);
-    r = fread(done_words, 1, want, fp);
-    fclose(fp);
-    return r == want;
-}
-
-static int cp_save_file(const char *path,
-                        int n,
-                        int target_length,
-                        long long total,
-                        int hint_s,
-                        int hint_t,
-                        int hint_used,
-                        const uint32_t *done_words,
-                        size_t words)
-{
-    char tmp[1024];
-    snprintf(tmp, sizeof tmp, "%s.tmp", path);
-    FILE *fp = fopen(tmp, "wb");
-    if (!fp) return 0;
-    cp_header_t h;
-    memcpy(h.magic, "GRCP", 4);
-    h.version = 1;
-    h.n = (uint32_t)n;
-    h.L = (uint32_t)target_length;
-    h.total = (uint64_t)total;
-    h.hint_s = (uint32_t)hint_s;
-    h.hint_t = (uint32_t)hint_t;
-    h.hint_used = (uint32_t)hint_used;
-    size_t w1 = fwrite(&h, 1, sizeof h, fp);
-    size_t w2 = fwrite(done_words, 1, words * sizeof(uint32_t), fp);
-    int ok = (w1 == sizeof h) && (w2 == words * sizeof(uint32_t));
-    if (fclose(fp) != 0) ok = 0;
-    if (!ok) { remove(tmp); return 0; }
-    if (rename(tmp, path) != 0) { remove(tmp); return 0; }
-    return 1;
-}
-#endif /* _OPENMP */
+#include <math.h>
 
 /* ==================== Optional ASM backends (weak symbols) ====================
  * These are hand-written assembler implementations for the distance-duplicate
@@ -110,51 +46,84 @@ extern int test_any_dup8_avx2_gather(const uint64_t *bs, const int *dist8)
         __attribute__((weak));  /* C AVX2 gather */
 extern int test_any_dup8_avx512(const uint64_t *bs, const int *dist8)
         __attribute__((weak));
+/* Width-specialised variants (bitset held in one register, see bs_words_for). */
+extern int test_any_dup8_avx2_w2(const uint64_t *bs, const int *dist8)
+        __attribute__((weak));  /* live width 2: vpermd */
+extern int test_any_dup8_avx2_w4(const uint64_t *bs, const int *dist8)
+        __attribute__((weak));  /* live width 4: vpermd */
+extern int test_any_dup8_avx512_w8(const uint64_t *bs, const int *dist8)
+        __attribute__((weak));  /* live width 8: vpermq */
 extern bool g_use_asm_fasm;  /* -af flag */
 extern bool g_use_asm_nasm;  /* -an flag */
 
 /* Intrinsic C fallback prototype (defined below). */
-static inline int test_any_dup8_avx2(const uint64_t *bs, const int *dist8);
+static int test_any_dup8_avx2(const uint64_t *bs, const int *dist8);
 
+/* Per-n kernel tables (dfs_kernels.c): one per instruction set with
+ * make FAT=1, otherwise only the -march=native one. */
+extern const dfs_run_fn g_dfs_kernels_native[MAX_MARKS + 1] __attribute__((weak));
+extern const dfs_run_fn g_dfs_kernels_sse42[MAX_MARKS + 1] __attribute__((weak));
+extern const dfs_run_fn g_dfs_kernels_avx2[MAX_MARKS + 1] __attribute__((weak));
+extern const dfs_run_fn g_dfs_kernels_avx512[MAX_MARKS + 1] __attribute__((weak));
 
-
-/* Cached env check for AVX-512 preference.
+/* Cached env flags and the engine chosen for this CPU (dfs_select).
  * Initialized once in solver entry points to avoid racy first-use. */
 static int g_use_avx512 = 0;
-static int g_avx512_inited = 0;
+static int g_no_kernels = 0;    /* GOLOMB_NO_KERNELS: generic dfs body only */
+static int g_no_hints = 0;      /* GOLOMB_NO_HINTS: -ho off as well */
+static int g_dispatch_inited = 0;
+static const dfs_run_fn *g_kernels = NULL;  /* per-n kernels, NULL: none */
+static dfs_run_fn g_generic_run = NULL;     /* generic body for the backend */
+static const char *g_kernels_isa = "none";
+
+static void dfs_select(void);
 
-static inline void init_avx512_flag(void)
+static inline void init_dispatch(void)
 {
-    if (!g_avx512_inited) {
+    if (!g_dispatch_inited) {
         g_use_avx512 = (getenv("GOLOMB_USE_AVX512") != NULL) ? 1 : 0;
-        g_avx512_inited = 1;
+        g_no_kernels = (getenv("GOLOMB_NO_KERNELS") != NULL) ? 1 : 0;
+        g_no_hints = (getenv("GOLOMB_NO_HINTS") != NULL) ? 1 : 0;
+        dfs_select();
+        g_dispatch_inited = 1;
     }
 }
 
-static inline int use_avx512_cached(void)
+/* ---------------------------------------------------------------------------
+ * dup8_* -- 8-distance duplicate tests, one per backend. Each generic
+ * engine instance below is built around one of them, so the choice
+ * (ASM FASM > ASM NASM > AVX-512 (env) > C AVX2) is made once in
+ * dfs_select() instead of on every call. The AVX-512 and C AVX2 paths use
+ * the register-resident variant for the live bitset width `words` where
+ * one exists (8 / 4 / 2) and gather from memory for the full 10-word width.
+ * Return 1 if ANY of the 8 distances already exists in the bitset.
+ * --------------------------------------------------------------------------- */
+static inline int dup8_fasm(const uint64_t *bs, const int *dist8, int words)
 {
-    return g_use_avx512;
+    (void)words;
+    return test_any_dup8_avx2_asm(bs, dist8);
 }
 
-/* ---------------------------------------------------------------------------
- * test_any_dup8 -- Runtime dispatch for 8-distance duplicate check.
- *
- * Priority: ASM FASM > ASM NASM > AVX-512 (env) > C AVX2 gather > intrinsic.
- * Returns 1 if ANY of the 8 distances already exists in the bitset.
- * --------------------------------------------------------------------------- */
-static inline int test_any_dup8(const uint64_t *bs, const int *dist8)
+static inline int dup8_nasm(const uint64_t *bs, const int *dist8, int words)
 {
-    /* -af flag: FASM unrolled scalar */
-    if (g_use_asm_fasm && test_any_dup8_avx2_asm)
-        return test_any_dup8_avx2_asm(bs, dist8);
-    /* -an flag: NASM AVX2 gather */
-    if (g_use_asm_nasm && test_any_dup8_avx2_nasm)
-        return test_any_dup8_avx2_nasm(bs, dist8);
-    /* Then AVX-512 if explicitly selected via env */
-    if (g_use_simd && test_any_dup8_avx512 && use_avx512_cached())
-        return test_any_dup8_avx512(bs, dist8);
-    /* Then C AVX2 gather (widely supported) */
-    if (g_use_simd && test_any_dup8_avx2_gather)
+    (void)words;
+    return test_any_dup8_avx2_nasm(bs, dist8);
+}
+
+static inline int dup8_avx512(const uint64_t *bs, const int *dist8, int words)
+{
+    if (words <= 8 && test_any_dup8_avx512_w8)
+        return test_any_dup8_avx512_w8(bs, dist8);
+    return test_any_dup8_avx512(bs, dist8);
+}
+
+static inline int dup8_avx2(const uint64_t *bs, const int *dist8, int words)
+{
+    if (words <= 2 && test_any_dup8_avx2_w2)
+        return test_any_dup8_avx2_w2(bs, dist8);
+    if (words <= 4 && test_any_dup8_avx2_w4)
+        return test_any_dup8_avx2_w4(bs, dist8);
+    if (test_any_dup8_avx2_gather)
         return test_any_dup8_avx2_gather(bs, dist8);
     return test_any_dup8_avx2(bs, dist8); /* intrinsic fallback */
 }
@@ -165,6 +134,8 @@ static inline int test_any_dup8(const uint64_t *bs, const int *dist8)
 bool g_use_simd = false;
 bool g_use_asm_fasm = false;  /* -af: FASM unrolled scalar */
 bool g_use_asm_nasm = false;  /* -an: NASM AVX2 gather */
+bool g_hint_order = false;    /* -ho: hint order at every depth */
+int g_lane_marks = 3;         /* -hk: marks the fast lane shares with the LUT */
 
 static inline void set_bit(uint64_t *bs, int idx) { bs[idx >> 6] |= 1ULL << (idx & 63); }
 static inline void clr_bit(uint64_t *bs, int idx) { bs[idx >> 6] &= ~(1ULL << (idx & 63)); }
@@ -178,9 +149,9 @@ static inline int  test_bit_scalar(const uint64_t *bs, int idx) { return (bs[idx
  * tests the appropriate bit in each word, and OR-reduces the result.
  * Returns 1 if ANY of the 4 distances already exists in the bitset.
  * --------------------------------------------------------------------------- */
+__attribute__((target("avx2")))
 static inline int test_any_dup_avx2(const uint64_t *bs, const int *dist4)
 {
-#if defined(__AVX2__)
     /* Load distances */
     __m128i idx32   = _mm_loadu_si128((const __m128i*)dist4);        /* 4 x int32 */
     __m128i words32 = _mm_srli_epi32(idx32, 6);                      /* distance>>6 (word index) */
@@ -196,120 +167,445 @@ static inline int test_any_dup_avx2(const uint64_t *bs, const int *dist4)
     /* AND to extract the tested bits, then OR-reduce by testz */
     __m256i dup = _mm256_and_si256(words64, masks);
     return !_mm256_testz_si256(dup, dup);
-#else
-    (void)bs; (void)dist4; return 0;
-#endif
 }
 
 /* Wrapper: check 8 distances by calling the 4-distance function twice. */
-static inline int test_any_dup8_avx2(const uint64_t *bs, const int *dist8)
+__attribute__((target("avx2")))
+static int test_any_dup8_avx2(const uint64_t *bs, const int *dist8)
 {
-#if defined(__AVX2__)
     return test_any_dup_avx2(bs, dist8) || test_any_dup_avx2(bs, dist8 + 4);
-#else
-    (void)bs; (void)dist8; return 0;
-#endif
 }
 
 #define test_bit(bs, idx) test_bit_scalar((bs), (idx))
 
 /* ===========================================================================
- * dfs -- Recursive branch-and-bound depth-first search.
+ * ITERATIVE DFS ENGINE (explicit stack)
  *
  * Places marks in ascending order (pos[0] < pos[1] < ... < pos[n-1]).
- * For each candidate position `next`:
+ * Instead of one recursive call per mark, the search walks a preallocated,
+ * cache-aligned array of frames. frame[d] belongs to the mark at index d and
+ * holds its candidate cursor, its upper bound and the distances it committed,
+ * so rollback needs no recomputation and the whole search state is plain data.
+ *
+ * For each candidate position `next` at depth d:
  *   1. Compute all distances from `next` to previously placed marks.
- *   2. If any distance already exists in the bitset -> prune (skip).
- *   3. Otherwise commit (set bits), recurse, and rollback on failure.
+ *   2. If any distance already exists in the bitset -> skip.
+ *   3. Otherwise commit (set bits, remember them in the frame) and descend.
+ * When a frame runs out of candidates the engine pops it and clears the bits
+ * the parent frame committed.
  *
- * The final mark must land exactly at target_len for the ruler to be valid.
+ * The final mark must land exactly at target_len for the ruler to be valid,
+ * so the last frame only ever tries `next == target_len`.
  *
  * Pruning strategies:
  *   - Lower bound: if placing remaining marks 1 apart can't reach target_len,
- *     prune immediately.
+ *     the frame is entered empty.
  *   - Symmetry break: the second mark (depth==1) is limited to <= L/2.
+ *   - Sub-ruler bounds: bounds_next_range() clips each frame's range with
+ *     the optimal lengths G(k) of smaller rulers (bounds.c).
+ *   - Distinct-gap bound: the remaining gaps are distinct unused distances;
+ *     their minimal sum is kept per frame and updated on commit.
  *   - SIMD acceleration: when depth >= 8, distances are checked 8 at a time
  *     using AVX2 gather (or ASM backend).
+ *
+ * Value order (-ho):
+ *   Candidates are normally tried in ascending order. With a LUT ruler for
+ *   n, each frame can instead start at the LUT's gap (pos[d-1] + its gap
+ *   d-1 -> d), run up to max_next, and take the candidates below the hint
+ *   last (wrap_lo..wrap_hi). Both parts are plain cursor ranges, so
+ *   splitting, snapshots for checkpoints and bounds work as before; a
+ *   prefix that follows the LUT ruler reaches it in n nodes. Not used in
+ *   branch-and-bound mode, where tighten only clips max_next.
+ *
+ * Suspension:
+ *   dfs_stack_run() takes a node budget. When it is used up the engine
+ *   returns DFS_SUSPENDED with the stack intact; calling it again continues
+ *   exactly where it stopped. dfs_stack_snapshot()/dfs_stack_restore()
+ *   convert the stack to and from a compact (pos, cursor) description for
+ *   checkpointing and work splitting. After DFS_FOUND the stack is also
+ *   resumable, which continues the search behind the reported ruler.
  * =========================================================================== */
-bool dfs(int depth, int n, int target_len, int *pos, uint64_t *dist_bs, bool verbose)
+
+/* Generic engine body: n is read from the stack at run time, one instance
+ * per duplicate-test backend (scalar, C AVX2, AVX-512, FASM, NASM). The
+ * per-n kernels generated from the same template live in dfs_kernels.c. */
+#define DFS_KERNEL_N 0
+#define DFS_SUFFIX _generic
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 0
+#define DFS_SUFFIX _avx2
+#define DFS_DUP8 dup8_avx2
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 0
+#define DFS_SUFFIX _avx512
+#define DFS_DUP8 dup8_avx512
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 0
+#define DFS_SUFFIX _fasm
+#define DFS_DUP8 dup8_fasm
+#include "dfs_engine.h"
+
+#define DFS_KERNEL_N 0
+#define DFS_SUFFIX _nasm
+#define DFS_DUP8 dup8_nasm
+#include "dfs_engine.h"
+
+/* ---------------------------------------------------------------------------
+ * cpu_isa -- Widest instruction set level this CPU runs (cpuid, cached):
+ * ISA_SSE42 = x86-64-v2, ISA_AVX2 = v3, ISA_AVX512 = v4. GOLOMB_ISA=base,
+ * sse42 or avx2 caps it, for A/B runs of the fat build.
+ * --------------------------------------------------------------------------- */
+int cpu_isa(void)
 {
-    if (depth == n)
+    static int isa = -1;
+    if (isa >= 0)
+        return isa;
+    int level = ISA_BASE;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt"))
     {
-        /* All n marks placed; valid iff the last mark equals L. */
-        return pos[n - 1] == target_len;
+        level = ISA_SSE42;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2") &&
+            __builtin_cpu_supports("fma"))
+        {
+            level = ISA_AVX2;
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+                __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl") &&
+                __builtin_cpu_supports("avx512cd"))
+                level = ISA_AVX512;
+        }
     }
-    int last = pos[depth - 1];
+#endif
+    const char *cap = getenv("GOLOMB_ISA");
+    if (cap)
+        for (int i = ISA_BASE; i < level; ++i)
+            if (strcmp(cap, cpu_isa_name(i)) == 0)
+                level = i;
+    isa = level;
+    return isa;
+}
 
-    /* Lower bound: even with minimum gaps of 1, can we still reach target_len? */
-    if (last + (n - depth) > target_len)
-        return false;
+const char *cpu_isa_name(int isa)
+{
+    static const char *const names[] = { "base", "sse42", "avx2", "avx512" };
+    return (isa >= ISA_BASE && isa <= ISA_AVX512) ? names[isa] : "?";
+}
+
+/* Kernel table and generic body for this CPU and the backend flags, picked
+ * once (init_dispatch); dfs_stack_run() only calls through them. */
+static void dfs_select(void)
+{
+    int isa = cpu_isa();
+    bool explicit_backend = g_use_asm_fasm || g_use_asm_nasm || g_use_avx512;
 
-    /* Upper bound for next mark: must leave room for (n-depth-1) more marks. */
-    int max_next = target_len - (n - depth - 1);
-    if (depth == 1)
+    g_kernels = NULL;
+    if (!g_no_kernels && !explicit_backend)
     {
-        int limit = target_len / 2; /* Symmetry break: second mark <= L/2 */
-        if (limit < last + 1)
-            limit = last + 1;
-        if (max_next > limit)
-            max_next = limit;
+        if (isa >= ISA_AVX512 && g_dfs_kernels_avx512)
+        {
+            g_kernels = g_dfs_kernels_avx512;
+            g_kernels_isa = "avx512";
+        }
+        else if (isa >= ISA_AVX2 && g_dfs_kernels_avx2)
+        {
+            g_kernels = g_dfs_kernels_avx2;
+            g_kernels_isa = "avx2";
+        }
+        else if (isa >= ISA_SSE42 && g_dfs_kernels_sse42)
+        {
+            g_kernels = g_dfs_kernels_sse42;
+            g_kernels_isa = "sse42";
+        }
+        else if (g_dfs_kernels_native)
+        {
+            g_kernels = g_dfs_kernels_native;
+            g_kernels_isa = "native";
+        }
     }
 
-    int dists[MAX_MARKS]; /* Pre-computed distances for current candidate */
+    if (g_use_asm_fasm && test_any_dup8_avx2_asm)
+        g_generic_run = dfs_stack_run_fasm;
+    else if (g_use_asm_nasm && test_any_dup8_avx2_nasm)
+        g_generic_run = dfs_stack_run_nasm;
+    else if (g_use_simd && g_use_avx512 && isa >= ISA_AVX512 && test_any_dup8_avx512)
+        g_generic_run = dfs_stack_run_avx512;
+    else if (g_use_simd && isa >= ISA_AVX2)
+        g_generic_run = dfs_stack_run_avx2;
+    else
+        g_generic_run = dfs_stack_run_generic;
+}
+
+const char *dfs_kernels_isa(void)
+{
+    init_dispatch();
+    return g_kernels ? g_kernels_isa : "none";
+}
+
+/* Hint marks for the value order of an n-mark search: the LUT ruler with -ho
+ * (unless GOLOMB_NO_HINTS), else NULL. */
+static const int *dfs_hint_marks(int n)
+{
+    init_dispatch();
+    if (!g_hint_order || g_no_hints)
+        return NULL;
+    const ruler_t *ref = lut_lookup_by_marks(n);
+    return ref ? ref->pos : NULL;
+}
+
+/* ---------------------------------------------------------------------------
+ * dfs_stack_run -- Kernel dispatcher.
+ *
+ * Uses the kernel specialised for st->n from the table dfs_select() chose
+ * for this CPU when one exists and no explicit duplicate-test backend (-af,
+ * -an, AVX-512) was requested; the generic body of the chosen backend
+ * otherwise. GOLOMB_NO_KERNELS=1 forces the generic body.
+ * --------------------------------------------------------------------------- */
+int dfs_stack_run(dfs_stack_t *st, long long budget)
+{
+    dfs_run_fn k = g_kernels ? g_kernels[st->n] : NULL;
+    if (!k)
+        k = g_generic_run ? g_generic_run : dfs_stack_run_generic;
+    return k(st, budget);
+}
+
+/* ---------------------------------------------------------------------------
+ * dfs_stack_init -- Prepare a search below the prefix pos[0..depth-1].
+ *
+ * dist_bs must hold exactly the distances of the prefix.
+ * --------------------------------------------------------------------------- */
+void dfs_stack_init(dfs_stack_t *st, int depth, int n, int target_len,
+                    const int *pos, const uint64_t *dist_bs, bool verbose)
+{
+    st->n = n;
+    st->target_len = target_len;
+    st->base = depth;
+    st->depth = depth;
+    st->verbose = verbose;
+    st->best = NULL;
+    st->hint = dfs_hint_marks(n);
+    st->bs_words = bs_words_for(target_len);
+    st->nodes = 0;
+    bounds_init();
+    memcpy(st->pos, pos, (size_t)depth * sizeof(int));
+    memcpy(st->dist_bs, dist_bs, (size_t)st->bs_words * sizeof(uint64_t));
+    if (depth < n)
+    {
+        dfs_frame_t *f = &st->frame[depth];
+        f->gap_sum = bounds_gap_sum_scan(st->dist_bs, n - depth, &f->gap_thr);
+        dfs_frame_enter_generic(st, depth);
+    }
+}
 
-    for (int next = last + 1; next <= max_next; ++next)
+/* ---------------------------------------------------------------------------
+ * dfs_stack_init_bb -- Like dfs_stack_init, but searches for any ruler
+ * shorter than the shared incumbent *best (branch-and-bound mode).
+ *
+ * Each DFS_FOUND reports a ruler with pos[n-1] < *best as read at that time;
+ * the caller lowers *best and resumes. The engine re-reads *best on resume
+ * and on every commit, so improvements by other threads prune at once.
+ * --------------------------------------------------------------------------- */
+void dfs_stack_init_bb(dfs_stack_t *st, int depth, int n, const int *pos,
+                       const uint64_t *dist_bs, int *best, bool verbose)
+{
+    init_dispatch();
+    int bound = __atomic_load_n(best, __ATOMIC_RELAXED) - 1;
+    if (bound > MAX_LEN_BITSET)
+        bound = MAX_LEN_BITSET;
+    st->n = n;
+    st->target_len = bound;
+    st->base = depth;
+    st->depth = depth;
+    st->verbose = verbose;
+    st->best = best;
+    st->hint = dfs_hint_marks(n);   /* -ho: the LUT ruler is the first incumbent */
+    st->bs_words = bs_words_for(bound);
+    st->nodes = 0;
+    bounds_init();
+    memcpy(st->pos, pos, (size_t)depth * sizeof(int));
+    memcpy(st->dist_bs, dist_bs, (size_t)st->bs_words * sizeof(uint64_t));
+    if (depth < n)
     {
-        /* Quick scalar pre-check: the gap to the immediate predecessor
-         * is the most likely duplicate (smallest new distance). */
-        int gap = next - last;
-        if (test_bit_scalar(dist_bs, gap))
-            continue;
+        dfs_frame_t *f = &st->frame[depth];
+        f->gap_sum = bounds_gap_sum_scan(st->dist_bs, n - depth, &f->gap_thr);
+        dfs_frame_enter_generic(st, depth);
+    }
+}
 
-        /* Compute all distances from `next` to every placed mark. */
-        bool ok = true;
-        for (int i = 0; i < depth; ++i)
-            dists[i] = next - pos[i];
+/* ---------------------------------------------------------------------------
+ * dfs_stack_snapshot / dfs_stack_restore -- Compact stack description.
+ *
+ * A snapshot stores the placed marks and the candidate cursor of every open
+ * frame; the bitset and the per-frame distances are rebuilt on restore.
+ * --------------------------------------------------------------------------- */
+void dfs_stack_snapshot(const dfs_stack_t *st, dfs_snapshot_t *snap)
+{
+    snap->n = st->n;
+    snap->target_len = st->target_len;
+    snap->base = st->base;
+    snap->depth = st->depth;
+    memcpy(snap->pos, st->pos, sizeof snap->pos);
+    for (int d = 0; d < MAX_MARKS; ++d)
+        snap->next[d] = (d >= st->base && d <= st->depth && d < st->n) ? st->frame[d].next : 0;
+}
 
-        /* Check for duplicates: SIMD path (8 at a time) or scalar. */
-        if (g_use_simd && depth >= 8) {
-            int i = 0;
-            for (; i + 8 <= depth; i += 8) {
-                if (test_any_dup8(dist_bs, &dists[i])) { ok = false; break; }
-            }
-            if (ok) {
-                for (; i < depth; ++i) {
-                    if (test_bit_scalar(dist_bs, dists[i])) { ok = false; break; }
-                }
-            }
-        } else {
-            for (int i = 0; i < depth; ++i) {
-                if (test_bit_scalar(dist_bs, dists[i])) {
-                    ok = false;
-                    break;
-                }
-            }
-        }
-        if (!ok)
-            continue;
+bool dfs_stack_restore(dfs_stack_t *st, const dfs_snapshot_t *snap, bool verbose)
+{
+    if (snap->n < 1 || snap->n > MAX_MARKS || snap->target_len > MAX_LEN_BITSET ||
+        snap->base < 1 || snap->depth < snap->base || snap->depth > snap->n)
+        return false;
+    init_dispatch();
 
-        /* Commit: place mark and set all new distance bits. */
-        pos[depth] = next;
-        for (int i = 0; i < depth; ++i)
-            set_bit(dist_bs, dists[i]);
+    st->n = snap->n;
+    st->target_len = snap->target_len;
+    st->base = snap->base;
+    st->depth = snap->depth;
+    st->verbose = verbose;
+    st->best = NULL;
+    st->hint = NULL;            /* snapshots record ascending cursors */
+    st->bs_words = bs_words_for(snap->target_len);
+    st->nodes = 0;
+    bounds_init();
+    memcpy(st->pos, snap->pos, sizeof st->pos);
+    memset(st->dist_bs, 0, (size_t)st->bs_words * sizeof(uint64_t));
 
-        if (verbose && depth < 6)
-            printf("depth %d add %d\n", depth, next);
+    /* Prefix distances, then each open frame's committed distances. Each
+     * frame's distinct-gap bound is taken from the bitset as it stood when
+     * the frame was entered. */
+    int top = (snap->depth < snap->n) ? snap->depth : snap->n;
+    for (int j = 1; j <= top; ++j)
+    {
+        if (j >= st->base && j < st->n)
+            st->frame[j].gap_sum = bounds_gap_sum_scan(st->dist_bs, st->n - j, &st->frame[j].gap_thr);
+        if (j == top)
+            break;
+        for (int i = 0; i < j; ++i)
+        {
+            int dist = st->pos[j] - st->pos[i];
+            if (dist <= 0 || dist > MAX_LEN_BITSET || test_bit_scalar(st->dist_bs, dist))
+                return false;
+            set_bit(st->dist_bs, dist);
+            if (j >= st->base)
+                st->frame[j].dists[i] = dist;
+        }
+    }
+    for (int d = st->base; d <= top && d < st->n; ++d)
+    {
+        dfs_frame_enter_generic(st, d);
+        st->frame[d].next = snap->next[d];
+    }
+    return true;
+}
 
-        if (dfs(depth + 1, n, target_len, pos, dist_bs, verbose))
-            return true;
+/* ---------------------------------------------------------------------------
+ * dfs_stack_init_task / dfs_stack_split -- Work splitting.
+ *
+ * A task is a prefix plus a candidate range for the next mark. Splitting
+ * the shallowest open frame gives away the largest untried subtrees, so a
+ * stolen task is rarely split again; the donor only shrinks max_next.
+ * --------------------------------------------------------------------------- */
+bool dfs_stack_init_task(dfs_stack_t *st, int n, int target_len, const dfs_task_t *t)
+{
+    if (t->depth < 1 || t->depth >= n || n > MAX_MARKS || target_len > MAX_LEN_BITSET)
+        return false;
+    uint64_t dist_bs[BS_WORDS];
+    memset(dist_bs, 0, (size_t)bs_words_for(target_len) * sizeof(uint64_t));
+    for (int j = 1; j < t->depth; ++j)
+        for (int i = 0; i < j; ++i)
+        {
+            int dist = t->pos[j] - t->pos[i];
+            if (dist <= 0 || dist > target_len || test_bit_scalar(dist_bs, dist))
+                return false;
+            set_bit(dist_bs, dist);
+        }
+    dfs_stack_init(st, t->depth, n, target_len, t->pos, dist_bs, false);
+    dfs_frame_t *f = &st->frame[t->depth];
+    if (f->next < t->lo) f->next = t->lo;
+    if (f->max_next > t->hi) f->max_next = t->hi;
+    if (f->wrap_lo < t->lo) f->wrap_lo = t->lo;
+    if (f->wrap_hi > t->hi) f->wrap_hi = t->hi;
+    return true;
+}
 
-        /* Rollback: clear all distance bits set in this step. */
-        for (int i = 0; i < depth; ++i)
-            clr_bit(dist_bs, dists[i]);
+bool dfs_stack_split(dfs_stack_t *st, dfs_task_t *t, int min_rest)
+{
+    int top = (st->depth < st->n) ? st->depth : st->n - 1;
+    for (int d = st->base; d <= top && st->n - d >= min_rest; ++d)
+    {
+        dfs_frame_t *f = &st->frame[d];
+        if (f->wrap_lo <= f->wrap_hi)
+        {
+            /* Hint order: the part below the hint goes whole. */
+            t->depth = d;
+            t->lo = f->wrap_lo;
+            t->hi = f->wrap_hi;
+            memcpy(t->pos, st->pos, (size_t)d * sizeof(int));
+            f->wrap_hi = f->wrap_lo - 1;
+            return true;
+        }
+        int rest = f->max_next - f->next + 1;
+        if (rest < 1)
+            continue;
+        int mid = f->next + rest / 2;   /* a single candidate goes whole */
+        t->depth = d;
+        t->lo = mid;
+        t->hi = f->max_next;
+        memcpy(t->pos, st->pos, (size_t)d * sizeof(int));
+        f->max_next = mid - 1;
+        return true;
     }
     return false;
 }
 
+/* ---------------------------------------------------------------------------
+ * dfs_stack_remaining -- What a suspended stack has left to search, as
+ * tasks: frame d contributes its untried candidates [next, max_next] below
+ * pos[0..d-1], and in hint order [wrap_lo, wrap_hi] as a second task; the
+ * subtree of its current mark is covered by the deeper frames. Deepest
+ * frame first, so a resumed search picks up the path it was on. Returns
+ * the number of tasks written to t[0..DFS_MAX_REMAINING-1].
+ * --------------------------------------------------------------------------- */
+int dfs_stack_remaining(const dfs_stack_t *st, dfs_task_t *t)
+{
+    int count = 0;
+    int top = (st->depth < st->n) ? st->depth : st->n - 1;
+    for (int d = top; d >= st->base; --d)
+    {
+        const dfs_frame_t *f = &st->frame[d];
+        int lo[2] = { f->next, f->wrap_lo };
+        int hi[2] = { f->max_next, f->wrap_hi };
+        for (int k = 0; k < 2; ++k)
+        {
+            if (lo[k] > hi[k])
+                continue;
+            dfs_task_t *x = &t[count++];
+            x->depth = d;
+            x->lo = lo[k];
+            x->hi = hi[k];
+            memcpy(x->pos, st->pos, (size_t)d * sizeof(int));
+        }
+    }
+    return count;
+}
+
+/* ---------------------------------------------------------------------------
+ * dfs -- Search below pos[0..depth-1] on the calling thread's preallocated
+ * stack. Fills pos[depth..n-1] and returns true if a ruler ending at
+ * target_len exists.
+ * --------------------------------------------------------------------------- */
+bool dfs(int depth, int n, int target_len, int *pos, uint64_t *dist_bs, bool verbose)
+{
+    static __thread dfs_stack_t st;
+    dfs_stack_init(&st, depth, n, target_len, pos, dist_bs, verbose);
+    if (dfs_stack_run(&st, 0) != DFS_FOUND)
+        return false;
+    memcpy(pos + depth, st.pos + depth, (size_t)(n - depth) * sizeof(int));
+    return true;
+}
+
 /* ---------------------------------------------------------------------------
  * solve_golomb -- Single-threaded entry point.
  *
@@ -320,7 +616,7 @@ bool solve_golomb(int n, int target_length, ruler_t *out, bool verbose)
 {
     if (n > MAX_MARKS || target_length > MAX_LEN_BITSET)
         return false;
-    init_avx512_flag();
+    init_dispatch();
     int pos[MAX_MARKS] = {0};
     uint64_t dist_bs[BS_WORDS] = {0};
 
@@ -337,140 +633,538 @@ bool solve_golomb(int n, int target_length, ruler_t *out, bool verbose)
  * MULTI-THREADED STATIC SOLVER (-mp)
  *
  * Parallelization strategy:
- *   1. Enumerate all valid (second, third) mark pairs.
- *   2. Optionally sort them by proximity to the LUT reference pair
- *      (candidates close to the known-optimal pair are tried first).
- *   3. Try the exact LUT pair as a "fast lane" before parallel search.
- *   4. Distribute candidates across threads via OpenMP taskloop.
- *   5. Each thread runs an independent DFS from depth 3 onwards.
- *   6. First thread to find a solution sets a shared flag; others stop.
+ *   1. Enumerate all valid prefixes of k marks (prefix_build: k = 3..6,
+ *      chosen from the worker count and a subtree-size estimate).
+ *   2. Optionally sort them by proximity to the LUT reference ruler
+ *      (candidates close to the known-optimal prefix are tried first).
+ *   3. The prefixes below the exact LUT (second, third) pair form the
+ *      "fast lane": they go to the pool as lane roots (wp_solve_lane), which
+ *      are claimed first and split on demand by every worker that comes
+ *      free, while the other candidates start right behind them.
+ *   4. Hand the candidates, in this order, to the work-stealing pool
+ *      (workpool.c) as root tasks. Idle workers split the running
+ *      subtrees of busy ones, so a few huge prefixes no longer decide the
+ *      wall time.
+ *   5. First worker to find a solution sets the pool's stop flag; the
+ *      others see it within one engine slice (no task cancellation).
+ *   Kernels other than dfs() (-sr, -mpa) cannot be split and keep the
+ *   OpenMP taskloop over whole candidates of depth 3 (or the depth of a
+ *   resumed checkpoint); their fast lane is expanded a few marks deeper
+ *   into tasks that are queued ahead of the taskloop.
  *
  * Checkpointing:
  *   A bitset tracks which candidates have been processed. Periodically
  *   flushed to disk (atomic file rename for crash safety). On resume,
- *   already-processed candidates are skipped.
+ *   already-processed candidates are skipped. With the pool a candidate
+ *   counts as processed once every part split from it is finished. A
+ *   resumed run rebuilds the prefixes at the depth whose candidate total
+ *   matches the file, whatever the thread count is now. Every -fi seconds
+ *   the pool also hands over a snapshot of its unfinished parts (GRCP v2),
+ *   so candidates in flight resume mid-subtree instead of from scratch.
+ *   The taskloop kernels only mark whole candidates; all kernels share
+ *   the file (kind CP_ROOTS_PREFIX), so -mp, -sr and -mpa resume each
+ *   other's checkpoints.
  * =========================================================================== */
 #ifdef _OPENMP
 #include <omp.h>
 #endif
+#include <pthread.h>
+
+/* ==================== Prefix generator ====================
+ *
+ * Root tasks of the fan-outs are prefixes pos[0..k-1], k = 3..6, stored as
+ * one flat array in a fixed order, so a candidate index (and with it the
+ * checkpoint bitset) means the same thing on every run with the same k.
+ *
+ * Each level is expanded from the previous one. A prefix of depth d gets
+ * its candidate range from bounds_frame_range(); the candidates that would
+ * repeat a distance are removed in bulk: every position pos[i] + delta
+ * (delta a prefix distance) is marked in a position bitset, and the
+ * survivors are read off the complement word by word.
+ *
+ * Depth choice (prefix_pick_depth): deepen while the array holds fewer
+ * than PREFIX_TASKS_PER_THREAD roots per worker, the estimated subtree per
+ * root is still large (b^(n-k) nodes, b the branching factor measured on
+ * the last expansion) and the next level fits PREFIX_MAX_ROOTS. Small
+ * orders therefore stay at k = 3; large orders on many threads go deeper.
+ *
+ * Hint order: the expansion yields the prefixes in lexicographic order, so
+ * ordering them by distance to the LUT ruler (ties lexicographic) is a
+ * stable bucket pass over the score, linear in the count. For the bare
+ * (second, third) pairs of -bb, pair_ring_t emits the same order directly,
+ * ring by ring around the LUT pair.
+ */
+#define PREFIX_MIN_DEPTH         3
+#define PREFIX_MAX_DEPTH         6
+#define PREFIX_TASKS_PER_THREAD  256
+#define PREFIX_MIN_NODES         1e10
+#define PREFIX_MAX_ROOTS         (1LL << 21)
 
+typedef struct {
+    uint16_t m[PREFIX_MAX_DEPTH];   /* marks m[0..depth-1], m[0] == 0 */
+    int score;                      /* distance to the LUT ruler (ordering) */
+} prefix_t;
 
-#ifdef _OPENMP
-/* File-scope comparator for candidate ordering (avoids GCC nested-function extension,
- * which requires executable stack trampolines incompatible with -Wl,-z,noexecstack). */
-typedef struct { int s, t, score; } cand_t;
-static int cand_cmp(const void *a, const void *b)
+typedef struct {
+    int depth;
+    long long count;
+    prefix_t *p;
+} prefix_list_t;
+
+static int prefix_cmp(const void *a, const void *b)
 {
-    const cand_t *x = (const cand_t*)a;
-    const cand_t *y = (const cand_t*)b;
+    const prefix_t *x = (const prefix_t*)a;
+    const prefix_t *y = (const prefix_t*)b;
     if (x->score != y->score) return x->score - y->score;
-    if (x->s != y->s)         return x->s - y->s;
-    return x->t - y->t;
+    for (int j = 1; j < PREFIX_MAX_DEPTH; ++j)
+        if (x->m[j] != y->m[j])
+            return (int)x->m[j] - (int)y->m[j];
+    return 0;
+}
+
+/* L1 distance of a prefix to the first marks of the LUT ruler. */
+static inline int prefix_score(const prefix_t *p, int depth, const ruler_t *ref)
+{
+    int score = 0;
+    for (int j = 1; j < depth; ++j)
+    {
+        int dj = p->m[j] - ref->pos[j];
+        score += (dj < 0) ? -dj : dj;
+    }
+    return score;
+}
+
+/* Puts a lexicographic list into hint order (score, then marks), i.e. what
+ * qsort with prefix_cmp gives, by counting the scores. */
+static void prefix_order_by_hint(prefix_list_t *pl, const ruler_t *ref)
+{
+    int smax = 0;
+    for (long long i = 0; i < pl->count; ++i)
+    {
+        pl->p[i].score = prefix_score(&pl->p[i], pl->depth, ref);
+        if (pl->p[i].score > smax)
+            smax = pl->p[i].score;
+    }
+    long long *at = (long long*)calloc((size_t)smax + 2, sizeof(long long));
+    prefix_t *tmp = (prefix_t*)malloc((size_t)pl->count * sizeof(prefix_t));
+    if (!at || !tmp)
+    {
+        free(at);
+        free(tmp);
+        qsort(pl->p, (size_t)pl->count, sizeof(prefix_t), prefix_cmp);
+        return;
+    }
+    for (long long i = 0; i < pl->count; ++i)
+        ++at[pl->p[i].score + 1];
+    for (int v = 1; v <= smax + 1; ++v)
+        at[v] += at[v - 1];
+    for (long long i = 0; i < pl->count; ++i)
+        tmp[at[pl->p[i].score]++] = pl->p[i];
+    free(at);
+    free(pl->p);
+    pl->p = tmp;
 }
-#endif
 
+#ifdef _OPENMP
 /* ---------------------------------------------------------------------------
- * solve_golomb_mt -- Static multi-threaded solver (OpenMP taskloop).
- *
- * For orders <= 3, delegates to single-threaded solver (overhead not worth it).
+ * pair_ring_t -- (second, third) pairs s in [1, smax], t in (s, tmax] in
+ * hint order without materialising them: ring r holds the pairs with
+ * |s - hs| + |t - ht| == r, walked by ascending s and, per s, the two
+ * candidates ht -+ (r - |s - hs|). Pairs are packed as s << 16 | t.
  * --------------------------------------------------------------------------- */
-bool solve_golomb_mt(int n, int target_length, ruler_t *out, bool verbose)
+typedef struct {
+    int hs, ht, smax, tmax;
+    int r, rmax;        /* current ring, last ring that can hold a pair */
+    int s, side;        /* next s of ring r; 0: t below ht, 1: t above */
+} pair_ring_t;
+
+static void pair_ring_init(pair_ring_t *g, int hs, int ht, int smax, int tmax)
 {
-#ifdef _OPENMP
-    if (n > MAX_MARKS || target_length > MAX_LEN_BITSET)
-        return false;
-    init_avx512_flag();
-    if (n <= 3)
+    g->hs = hs;
+    g->ht = ht;
+    g->smax = smax;
+    g->tmax = tmax;
+    int ds = (hs - 1 > smax - hs) ? hs - 1 : smax - hs;
+    int dt = (ht - 2 > tmax - ht) ? ht - 2 : tmax - ht;
+    g->rmax = (ds > 0 ? ds : 0) + (dt > 0 ? dt : 0);
+    g->r = 0;
+    g->s = (hs > 1) ? hs : 1;
+    g->side = 0;
+}
+
+static bool pair_ring_next(pair_ring_t *g, uint32_t *st)
+{
+    while (g->r <= g->rmax)
     {
-        return solve_golomb(n, target_length, out, verbose);
+        int shi = (g->hs + g->r < g->smax) ? g->hs + g->r : g->smax;
+        while (g->s <= shi)
+        {
+            int ds = (g->s > g->hs) ? g->s - g->hs : g->hs - g->s;
+            int rem = g->r - ds;
+            int t = (g->side == 0) ? g->ht - rem : g->ht + rem;
+            int s = g->s;
+            if (g->side == 0 && rem > 0)
+                g->side = 1;
+            else
+            {
+                g->side = 0;
+                ++g->s;
+            }
+            if (rem >= 0 && t > s && t <= g->tmax)
+            {
+                *st = (uint32_t)s << 16 | (uint32_t)t;
+                return true;
+            }
+        }
+        ++g->r;
+        g->s = (g->hs - g->r > 1) ? g->hs - g->r : 1;
+        g->side = 0;
     }
-    volatile int found = 0; /* shared flag */
-    ruler_t res_local;
+    return false;
+}
+#endif
 
-    int half = target_length / 2; /* symmetry break */
-    /* After placing pos[2]=t there are (n-3) further marks, each with min gap 1,
-     * so pos[n-1] >= t + (n-3). Hence t <= L - (n-3). */
-    int T = target_length - (n - 3);
-    int second_max = half;
-    if (second_max > T - 1) second_max = T - 1;
-    if (second_max < 1) second_max = 1;
+/* Expands every prefix of `in` by one mark into `out`; false if out of
+ * memory or more than `cap` children. */
+static bool prefix_expand(int n, int L, const prefix_list_t *in, prefix_list_t *out, long long cap)
+{
+    const int d = in->depth;
+    const int bsw = bs_words_for(L);
+    long long size = in->count > 0 ? in->count * 4 : 16;
+    out->depth = d + 1;
+    out->count = 0;
+    out->p = NULL;
+    if (d < 1 || d >= PREFIX_MAX_DEPTH)
+        return false;
+    out->p = (prefix_t*)malloc((size_t)size * sizeof(prefix_t));
+    if (!out->p)
+        return false;
 
-    /* If we have a LUT reference for this n, prefer candidates near its (second,third) */
-    extern const ruler_t *lut_lookup_by_marks(int);
-    const ruler_t *ref = lut_lookup_by_marks(n);
+    for (long long k = 0; k < in->count; ++k)
+    {
+        int pos[MAX_MARKS];
+        uint64_t dist_bs[BS_WORDS];
+        uint64_t forb[BS_WORDS];
+        memset(dist_bs, 0, (size_t)bsw * sizeof(uint64_t));
+        memset(forb, 0, (size_t)bsw * sizeof(uint64_t));
+        for (int j = 0; j < d; ++j)
+        {
+            pos[j] = in->p[k].m[j];
+            for (int i = 0; i < j; ++i)
+                set_bit(dist_bs, pos[j] - pos[i]);
+        }
+
+        int lohi[2];
+        lohi[0] = (d == n - 1) ? L : pos[d - 1] + 1;
+        lohi[1] = L - (n - d - 1);
+        if (d == 1 && lohi[1] > L / 2)
+            lohi[1] = L / 2;              /* symmetry break */
+        if (lohi[0] > lohi[1] || !bounds_frame_range(d, n, L, pos, dist_bs, lohi))
+            continue;
+
+        /* Bulk duplicate filter: next is forbidden iff next - pos[i] is a
+         * prefix distance for some i. */
+        for (int w = 0; w < bsw; ++w)
+            for (uint64_t b = dist_bs[w]; b; b &= b - 1)
+            {
+                int delta = (w << 6) + __builtin_ctzll(b);
+                for (int i = 0; i < d; ++i)
+                    if (pos[i] + delta <= L)
+                        set_bit(forb, pos[i] + delta);
+            }
 
-    /* Fast lane: try the exact LUT (second,third) first (positions still solved via DFS). */
-    if (ref && !getenv("GOLOMB_NO_HINTS")) {
-        int s0 = ref->pos[1];
-        int t0 = ref->pos[2];
-        if (s0 >= 1 && s0 <= second_max && t0 > s0 && t0 <= T) {
-            uint64_t dist_bs0[BS_WORDS] = {0};
-            int pos0[MAX_MARKS];
-            pos0[0] = 0; pos0[1] = s0; pos0[2] = t0;
-            set_bit(dist_bs0, s0);
-            int d13 = t0;
-            int d23 = t0 - s0;
-            if (!test_bit(dist_bs0, d13) && !test_bit(dist_bs0, d23)) {
-                set_bit(dist_bs0, d13);
-                set_bit(dist_bs0, d23);
-                if (dfs(3, n, target_length, pos0, dist_bs0, false)) {
-                    out->marks = n;
-                    out->length = pos0[n - 1];
-                    memcpy(out->pos, pos0, n * sizeof(int));
-                    return true;
+        for (int w = lohi[0] >> 6; w <= lohi[1] >> 6; ++w)
+        {
+            uint64_t ok = ~forb[w];
+            if (w == (lohi[0] >> 6)) ok &= ~0ULL << (lohi[0] & 63);
+            if (w == (lohi[1] >> 6)) ok &= ~0ULL >> (63 - (lohi[1] & 63));
+            for (; ok; ok &= ok - 1)
+            {
+                if (out->count == cap)
+                    return false;
+                if (out->count == size)
+                {
+                    size *= 2;
+                    prefix_t *np = (prefix_t*)realloc(out->p, (size_t)size * sizeof(prefix_t));
+                    if (!np)
+                        return false;
+                    out->p = np;
                 }
+                prefix_t *c = &out->p[out->count++];
+                *c = in->p[k];
+                c->m[d] = (uint16_t)((w << 6) + __builtin_ctzll(ok));
             }
         }
     }
-    long long total = 0;
-    /* Worst-case pairs is ~second_max*(T-second_max/2) < 1e6 for our ranges, malloc ok */
-    cand_t *cands = NULL;
-    if (second_max >= 1) {
-        /* count total */
-        for (int s = 1; s <= second_max; ++s) {
-            int cnt = T - s;
-            if (cnt > 0) total += cnt;
+    return true;
+}
+
+/* ---------------------------------------------------------------------------
+ * prefix_build -- Root prefixes of depth k for (n, L).
+ *
+ * k > 0 fixes the depth; k == 0 picks it for `threads` workers (see above),
+ * except that `want_count` > 0 (the candidate total of a checkpoint being
+ * resumed) deepens until that many roots exist, so the resumed run uses the
+ * depth the checkpoint was written with. `ref` (may be NULL) orders the
+ * roots by distance to its marks. Returns false if out of memory.
+ * --------------------------------------------------------------------------- */
+static bool prefix_build(int n, int L, int k, int threads, long long want_count,
+                         const ruler_t *ref, prefix_list_t *out)
+{
+    bounds_init();
+    prefix_list_t cur;
+    cur.depth = 1;
+    cur.count = 1;
+    cur.p = (prefix_t*)calloc(1, sizeof(prefix_t));
+    if (!cur.p)
+        return false;
+    long long parents = 1;
+    int kmax = (n - 1 < PREFIX_MAX_DEPTH) ? n - 1 : PREFIX_MAX_DEPTH;
+
+    for (;;)
+    {
+        if (cur.depth >= PREFIX_MIN_DEPTH || cur.depth >= kmax)
+        {
+            if (k > 0)
+            {
+                if (cur.depth >= k || cur.depth >= kmax)
+                    break;
+            }
+            else if (want_count > 0)
+            {
+                if (cur.count >= want_count || cur.depth >= kmax)
+                    break;
+            }
+            else
+            {
+                double b = (double)cur.count / (double)(parents > 0 ? parents : 1);
+                double est = 1.0;
+                for (int r = cur.depth; r < n && est < PREFIX_MIN_NODES; ++r)
+                    est *= b;
+                if (cur.depth >= kmax ||
+                    cur.count >= (long long)threads * PREFIX_TASKS_PER_THREAD ||
+                    est < PREFIX_MIN_NODES ||
+                    cur.count * b > (double)PREFIX_MAX_ROOTS)
+                    break;
+            }
+        }
+        prefix_list_t next;
+        if (!prefix_expand(n, L, &cur, &next, PREFIX_MAX_ROOTS))
+        {
+            free(next.p);
+            if (cur.depth >= PREFIX_MIN_DEPTH || cur.depth >= kmax)
+                break;                    /* keep the last complete level */
+            free(cur.p);
+            return false;
         }
-        cands = (cand_t*)malloc((size_t)total * sizeof(cand_t));
+        parents = cur.count;
+        free(cur.p);
+        cur = next;
     }
-    long long k = 0;
-    int use_hint_order = (ref && !getenv("GOLOMB_NO_HINTS")) ? 1 : 0;
-    for (int s = 1; s <= second_max; ++s) {
-        for (int t = s + 1; t <= T; ++t) {
-            int score = 0;
-            if (use_hint_order) {
-                int ds = s - ref->pos[1]; if (ds < 0) ds = -ds;
-                int dt = t - ref->pos[2]; if (dt < 0) dt = -dt;
-                score = ds + dt;
-            }
-            cands[k++] = (cand_t){ s, t, score };
+
+    if (ref && cur.count > 1)
+        prefix_order_by_hint(&cur, ref);
+    *out = cur;
+    return true;
+}
+
+/* Root i of the pool: the prefix itself, next mark unrestricted. */
+static void prefix_task(const prefix_list_t *pl, long long i, dfs_task_t *t)
+{
+    t->depth = pl->depth;
+    t->lo = 0;
+    t->hi = MAX_LEN_BITSET;
+    for (int j = 0; j < pl->depth; ++j)
+        t->pos[j] = pl->p[i].m[j];
+}
+
+/* Second and third mark of root i (cp_open_prefix, version 1 files). */
+static void prefix_pair(const void *ctx, long long i, int *second, int *third)
+{
+    const prefix_list_t *pl = (const prefix_list_t*)ctx;
+    *second = pl->p[i].m[1];
+    *third = pl->p[i].m[2];
+}
+
+/* Root tasks of the prefix fan-out for the pool. */
+typedef struct {
+    const prefix_list_t *pl;
+    cp_state_t *cp;             /* NULL: no checkpointing */
+} prefix_ctx_t;
+
+static bool prefix_root(void *ctx, long long i, dfs_task_t *t)
+{
+    const prefix_ctx_t *c = (const prefix_ctx_t*)ctx;
+    if (c->cp && cp_is_done(c->cp, i))
+        return false;
+    prefix_task(c->pl, i, t);
+    return true;
+}
+
+static void prefix_root_done(void *ctx, long long i)
+{
+    const prefix_ctx_t *c = (const prefix_ctx_t*)ctx;
+    if (c->cp)
+        cp_mark_done(c->cp, i);
+}
+
+/* ==================== Fast lane ====================
+ *
+ * The roots that share their first g_lane_marks marks (-hk, default 3: the
+ * (second, third) pair) with the LUT ruler; a root shorter than that must
+ * match in full. Before they were searched as one subtree on one thread
+ * ahead of the fan-out, which for large n idled every other core for
+ * minutes.
+ */
+#define PREFIX_LANE_TASKS_PER_THREAD 16
+
+typedef struct {
+    const ruler_t *ref;
+    int marks;                  /* leading marks shared with ref */
+    long long *roots;           /* list indices, in list order */
+    long long count;            /* 0: no lane */
+} prefix_lane_t;
+
+static inline bool prefix_in_lane(const prefix_t *p, int marks, const ruler_t *ref)
+{
+    for (int j = 1; j < marks; ++j)
+        if (p->m[j] != ref->pos[j])
+            return false;
+    return true;
+}
+
+/* Lane of pl for the LUT ruler ref (NULL: none); empty if out of memory. */
+static void prefix_lane_find(const prefix_list_t *pl, const ruler_t *ref, prefix_lane_t *lane)
+{
+    lane->ref = ref;
+    lane->roots = NULL;
+    lane->count = 0;
+    lane->marks = (g_lane_marks < pl->depth) ? g_lane_marks : pl->depth;
+    if (!ref || lane->marks < 2)
+        return;
+    long long cnt = 0;
+    for (long long i = 0; i < pl->count; ++i)
+        cnt += prefix_in_lane(&pl->p[i], lane->marks, ref);
+    if (cnt == 0 || !(lane->roots = (long long*)malloc((size_t)cnt * sizeof(long long))))
+        return;
+    for (long long i = 0; i < pl->count; ++i)
+        if (prefix_in_lane(&pl->p[i], lane->marks, ref))
+            lane->roots[lane->count++] = i;
+}
+
+/* Default subtree kernel for the prefix fan-out: the recursive dfs(). */
+static bool dfs_prefix_kernel(int depth, int n, int target_len, int *pos, uint64_t *dist_bs)
+{
+    return dfs(depth, n, target_len, pos, dist_bs, false);
+}
+
+#ifdef _OPENMP
+/* A taskloop lane task and the lane root (index into the lane) it is from. */
+typedef struct {
+    prefix_t p;
+    int k;
+} lane_task_t;
+
+static int lane_task_cmp(const void *a, const void *b)
+{
+    return prefix_cmp(&((const lane_task_t*)a)->p, &((const lane_task_t*)b)->p);
+}
+
+/* Taskloop fast lane: the lane roots not done yet, expanded until every
+ * thread gets a few tasks and put in hint order. open[] counts the tasks
+ * of each lane root and skip[] marks the expanded roots for the taskloop;
+ * roots without any task are marked done here. Returns the task count,
+ * 0 (no lane) if out of memory. */
+static long long prefix_lane_expand(int n, int L, const prefix_ctx_t *ctx,
+                                    const prefix_lane_t *lane, lane_task_t **tasks,
+                                    int *depth, int **open, unsigned char **skip)
+{
+    const prefix_list_t *pl = ctx->pl;
+    prefix_list_t sub;
+    sub.depth = pl->depth;
+    sub.count = 0;
+    sub.p = (prefix_t*)malloc((size_t)lane->count * sizeof(prefix_t));
+    *tasks = NULL;
+    *open = (int*)calloc((size_t)lane->count, sizeof(int));
+    *skip = (unsigned char*)calloc((size_t)pl->count, 1);
+    if (!sub.p || !*open || !*skip)
+        goto fail;
+    /* score carries the lane index through the expansion. */
+    for (long long k = 0; k < lane->count; ++k)
+    {
+        long long i = lane->roots[k];
+        if (ctx->cp && cp_is_done(ctx->cp, i))
+            continue;
+        sub.p[sub.count] = pl->p[i];
+        sub.p[sub.count++].score = (int)k;
+    }
+    int kmax = (n - 1 < PREFIX_MAX_DEPTH) ? n - 1 : PREFIX_MAX_DEPTH;
+    long long want = (long long)omp_get_max_threads() * PREFIX_LANE_TASKS_PER_THREAD;
+    while (sub.count > 0 && sub.count < want && sub.depth < kmax)
+    {
+        prefix_list_t next;
+        if (!prefix_expand(n, L, &sub, &next, PREFIX_MAX_ROOTS))
+        {
+            free(next.p);
+            break;                      /* keep the last complete level */
         }
+        free(sub.p);
+        sub = next;
     }
-    if (use_hint_order && cands && total > 1) {
-        qsort(cands, (size_t)total, sizeof(cand_t), cand_cmp);
+    *tasks = (lane_task_t*)malloc((size_t)(sub.count > 0 ? sub.count : 1) * sizeof(lane_task_t));
+    if (!*tasks)
+        goto fail;
+    for (long long j = 0; j < sub.count; ++j)
+    {
+        (*tasks)[j].k = sub.p[j].score;
+        (*tasks)[j].p = sub.p[j];
+        (*tasks)[j].p.score = prefix_score(&sub.p[j], sub.depth, lane->ref);
+        ++(*open)[sub.p[j].score];
+    }
+    qsort(*tasks, (size_t)sub.count, sizeof(lane_task_t), lane_task_cmp);
+    for (long long k = 0; k < lane->count; ++k)
+    {
+        long long i = lane->roots[k];
+        if (ctx->cp && cp_is_done(ctx->cp, i))
+            continue;
+        (*skip)[i] = 1;
+        if ((*open)[k] == 0)
+            prefix_root_done((void*)ctx, i);
     }
+    *depth = sub.depth;
+    free(sub.p);
+    return sub.count;
 
-    /* ---------------- Checkpoint/Resume setup (only for -mp) ---------------- */
-    extern const char *g_cp_path;
-    extern int g_cp_interval_sec;
-    uint32_t *done_words = NULL; /* bitset: 1 = candidate processed */
-    size_t words = (size_t)((total + 31) / 32);
-    if (words == 0) words = 1;
-    done_words = (uint32_t*)calloc(words, sizeof(uint32_t));
-    if (!done_words) { free(cands); return false; }
+fail:
+    free(sub.p);
+    free(*tasks);
+    free(*open);
+    free(*skip);
+    *tasks = NULL;
+    *open = NULL;
+    *skip = NULL;
+    return 0;
+}
 
-    int use_cp = (g_cp_path && *g_cp_path) ? 1 : 0;
-    if (use_cp) {
-        int hs = use_hint_order && ref ? ref->pos[1] : 0;
-        int ht = use_hint_order && ref ? ref->pos[2] : 0;
-        (void)cp_load_file(g_cp_path, n, target_length, total, hs, ht, use_hint_order, done_words, words);
-        /* Create or refresh the checkpoint file immediately so users can see it early */
-        (void)cp_save_file(g_cp_path, n, target_length, total, hs, ht, use_hint_order, done_words, words);
-    }
-    int interval = (g_cp_interval_sec > 0) ? g_cp_interval_sec : 60;
-    struct timespec ts_last_flush; clock_gettime(CLOCK_MONOTONIC, &ts_last_flush);
+/* Whole-candidate OpenMP taskloop for kernels the pool cannot split. The
+ * lane tasks are the first iterations, so they are queued ahead of the
+ * other roots, which follow without waiting for the lane. */
+static bool prefix_taskloop(int n, int target_length, prefix_kernel_fn kernel,
+                            const prefix_ctx_t *ctx, long long total,
+                            const prefix_lane_t *lane, ruler_t *out)
+{
+    volatile int found = 0; /* shared flag */
+    ruler_t res_local;
+    /* Tasks clear and copy only the live bitset words for this L. */
+    const int bsw = bs_words_for(target_length);
+    lane_task_t *sub = NULL;
+    int sub_depth = 0;
+    int *lane_open = NULL;
+    unsigned char *skip = NULL;
+    const long long nsub = (lane->count > 0)
+        ? prefix_lane_expand(n, target_length, ctx, lane, &sub, &sub_depth, &lane_open, &skip)
+        : 0;
 
-    /* Parallelise across ordered candidate list using a task-based model */
 #pragma omp parallel
     {
 #pragma omp single
@@ -478,38 +1172,31 @@ bool solve_golomb_mt(int n, int target_length, ruler_t *out, bool verbose)
 #pragma omp taskgroup
             {
 #pragma omp taskloop grainsize(1)
-                for (long long i = 0; i < total; ++i)
+                for (long long j = 0; j < nsub + total; ++j)
                 {
                     if (found)
                     {
                         continue;
                     }
-                    /* skip already processed candidate if resuming */
-                    if (use_cp)
+                    long long i = j - nsub;   /* root, or < 0: lane task */
+                    dfs_task_t t;
+                    if (i < 0)
                     {
-                        size_t wi = (size_t)(i >> 5);
-                        uint32_t mask = 1u << (i & 31);
-                        if (done_words[wi] & mask)
-                            continue;
+                        t.depth = sub_depth;
+                        for (int m = 0; m < sub_depth; ++m)
+                            t.pos[m] = sub[j].p.m[m];
                     }
-                    int second = cands[i].s;
-                    int third = cands[i].t;
-                    /* local state per iteration */
-                    uint64_t dist_bs[BS_WORDS] = {0};
-                    int pos[MAX_MARKS];
-                    pos[0] = 0;
-                    pos[1] = second;
-                    pos[2] = third;
-                    set_bit(dist_bs, second);
-                    int d13 = third;          /* third - 0 */
-                    int d23 = third - second; /* third - second */
-                    /* quick duplicate tests before committing */
-                    if (test_bit(dist_bs, d13) || test_bit(dist_bs, d23))
+                    else if ((skip && skip[i]) || !prefix_root((void*)ctx, i, &t))
                         continue;
-                    set_bit(dist_bs, d13);
-                    set_bit(dist_bs, d23);
+                    /* local state per iteration */
+                    uint64_t dist_bs[BS_WORDS];
+                    memset(dist_bs, 0, (size_t)bsw * sizeof(uint64_t));
+                    int *pos = t.pos;
+                    for (int m = 1; m < t.depth; ++m)
+                        for (int a = 0; a < m; ++a)
+                            set_bit(dist_bs, pos[m] - pos[a]);
 
-                    if (dfs(3, n, target_length, pos, dist_bs, false))
+                    if (kernel(t.depth, n, target_length, pos, dist_bs))
                     {
                         int old_found;
 #pragma omp atomic capture
@@ -525,156 +1212,523 @@ bool solve_golomb_mt(int n, int target_length, ruler_t *out, bool verbose)
 #pragma omp cancel taskgroup
                         }
                     }
-                    /* mark candidate processed and possibly flush checkpoint */
-                    if (use_cp)
+                    else if (i >= 0)
                     {
-                        size_t wi = (size_t)(i >> 5);
-                        uint32_t mask = 1u << (i & 31);
-                        __sync_fetch_and_or(&done_words[wi], mask);
-                        struct timespec ts_now;
-                        clock_gettime(CLOCK_MONOTONIC, &ts_now);
-                        time_t dt = ts_now.tv_sec - ts_last_flush.tv_sec;
-                        if (dt >= interval)
-                        {
-#pragma omp critical(cp_io)
-                            {
-                                /* re-check inside critical to avoid thundering herd */
-                                struct timespec ts_chk;
-                                clock_gettime(CLOCK_MONOTONIC, &ts_chk);
-                                if (ts_chk.tv_sec - ts_last_flush.tv_sec >= interval)
-                                {
-                                    int hs2 = use_hint_order && ref ? ref->pos[1] : 0;
-                                    int ht2 = use_hint_order && ref ? ref->pos[2] : 0;
-                                    (void)cp_save_file(g_cp_path, n, target_length, total, hs2, ht2, use_hint_order, done_words, words);
-                                    ts_last_flush = ts_chk;
-                                }
-                            }
-                        }
+                        /* mark candidate processed and possibly flush checkpoint
+                         * (never the one with the ruler: a file with every bit
+                         * set proves L infeasible) */
+                        prefix_root_done((void*)ctx, i);
+                    }
+                    else
+                    {
+                        /* the last task of a lane root completes it */
+                        int k = sub[j].k;
+                        if (__atomic_sub_fetch(&lane_open[k], 1, __ATOMIC_ACQ_REL) == 0)
+                            prefix_root_done((void*)ctx, lane->roots[k]);
                     }
                 }
             } /* end taskgroup */
         }     /* end single */
     }         /* end parallel */
-    if (use_cp) {
-        int hs = use_hint_order && ref ? ref->pos[1] : 0;
-        int ht = use_hint_order && ref ? ref->pos[2] : 0;
-        (void)cp_save_file(g_cp_path, n, target_length, total, hs, ht, use_hint_order, done_words, words);
-    }
+    free(sub);
+    free(lane_open);
+    free(skip);
     if (found)
-    {
         *out = res_local;
-        free(cands);
-        free(done_words);
-        return true;
-    }
-    free(cands);
-    free(done_words);
-    return false;
-#else /* !_OPENMP */
-    return solve_golomb(n, target_length, out, verbose);
+    return found;
+}
 #endif
 
+/* ---------------------------------------------------------------------------
+ * solve_golomb_mt -- Static multi-threaded solver (work-stealing pool).
+ *
+ * For orders <= 3, delegates to single-threaded solver (overhead not worth it).
+ * --------------------------------------------------------------------------- */
+bool solve_golomb_mt(int n, int target_length, ruler_t *out, bool verbose)
+{
+    return solve_golomb_prefix_mt(n, target_length, out, verbose, dfs_prefix_kernel);
 }
 
-/* ===========================================================================
- * DYNAMIC TASK SOLVER (-d)
- *
- * Uses OpenMP taskloop with cancellation for finer-grained load balancing.
- * Each (second, third) pair becomes an independent task. When one task finds
- * a solution, `omp cancel taskgroup` stops all remaining tasks.
+/* ---------------------------------------------------------------------------
+ * solve_golomb_prefix_mt -- (second, third) prefix fan-out shared by -mp and
+ * every engine that plugs in its own subtree kernel (e.g. -sr).
  *
- * Trade-off: higher per-task overhead than -mp, but better load balancing
- * when subtree sizes vary significantly. Requires OMP_CANCELLATION=TRUE.
- * =========================================================================== */
-bool solve_golomb_mt_dyn(int n, int target_length,
-                         ruler_t *out, bool verbose)
+ * Candidate ordering, LUT fast lane and checkpointing are identical for all
+ * kernels, so a checkpoint written by one kernel can be resumed by another.
+ * --------------------------------------------------------------------------- */
+bool solve_golomb_prefix_mt(int n, int target_length, ruler_t *out, bool verbose,
+                            prefix_kernel_fn kernel)
 {
-#ifdef _OPENMP
     if (n > MAX_MARKS || target_length > MAX_LEN_BITSET)
         return false;
-    init_avx512_flag();
+    init_dispatch();
+#ifndef _OPENMP
+    if (kernel != dfs_prefix_kernel)
+        return solve_golomb(n, target_length, out, verbose);
+#endif
     if (n <= 3)
+    {
         return solve_golomb(n, target_length, out, verbose);
+    }
 
-    volatile int found = 0; /* shared flag  */
-    ruler_t local;          /* winning ruler */
+    /* If we have a LUT reference for this n, prefer candidates near its (second,third) */
+    extern const ruler_t *lut_lookup_by_marks(int);
+    const ruler_t *ref = lut_lookup_by_marks(n);
+    int use_hint_order = (ref && !getenv("GOLOMB_NO_HINTS")) ? 1 : 0;
 
-    const int half = target_length / 2;             /* symmetry break */
-    const int T    = target_length - (n - 3);       /* tight bound for third */
-    int second_max = half;
-    if (second_max > T - 1) second_max = T - 1;
-    if (second_max < 1) second_max = 1;
+    /* ---------------- Checkpoint/Resume setup ---------------- */
+    int use_cp = (g_cp_path && *g_cp_path) ? 1 : 0;
+    cp_key_t key = { n, target_length, CP_ROOTS_PREFIX,
+                     use_hint_order ? ref->pos[1] : 0, use_hint_order ? ref->pos[2] : 0,
+                     use_hint_order };
 
-    /* Flatten (second, third) pair space so taskloop balances uniformly. */
-    long long total = 0;
-    for (int s = 1; s <= second_max; ++s) {
-        int cnt = T - s;
-        if (cnt > 0) total += cnt;
-    }
-    if (total <= 0) return false;
+    /* Root prefixes: depth 3 for external kernels, adaptive for dfs(); a
+     * checkpoint being resumed fixes the depth, whichever kernel wrote it. */
+    long long cp_total = use_cp ? cp_peek_total(g_cp_path, &key) : 0;
+    int k = (cp_total > 0 || kernel == dfs_prefix_kernel) ? 0 : PREFIX_MIN_DEPTH;
+    prefix_list_t pl;
+    if (!prefix_build(n, target_length, k, wp_num_threads(), cp_total,
+                      use_hint_order ? ref : NULL, &pl))
+        return false;
+    long long total = pl.count;
+    if (verbose)
+        printf("[MP] L=%d: %lld root prefixes of depth %d\n", target_length, total, pl.depth);
+    if (total <= 0) { free(pl.p); return false; }
 
-    cand_t *cands = (cand_t*)malloc((size_t)total * sizeof(cand_t));
-    if (!cands) return false;
+    cp_state_t *cp = NULL;
+    if (use_cp)
     {
-        long long k = 0;
-        for (int s = 1; s <= second_max; ++s)
-            for (int t = s + 1; t <= T; ++t)
-                cands[k++] = (cand_t){ s, t, 0 };
+        cp = cp_open_prefix(g_cp_path, &key, total, prefix_pair, &pl);
+        if (!cp) { free(pl.p); return false; }
+    }
+    prefix_ctx_t ctx = { &pl, cp };
+    /* Fast lane: searched in parallel ahead of the other roots. */
+    prefix_lane_t lane;
+    prefix_lane_find(&pl, use_hint_order ? ref : NULL, &lane);
+    if (verbose && lane.count > 0)
+    {
+        printf("[MP] fast lane [0");
+        for (int j = 1; j < lane.marks; ++j)
+            printf(", %d", ref->pos[j]);
+        printf("]: %lld root prefixes%s\n", lane.count,
+               dfs_hint_marks(n) ? ", hint order" : "");
     }
 
-#pragma omp parallel
+    /* Size estimates (-vt): progress/ETA for the heartbeat, and without
+     * LUT hints the largest subtrees are dispatched first. The order must
+     * not depend on -vt when a checkpoint indexes it. */
+    if (g_estimate && kernel == dfs_prefix_kernel && total <= EST_PROBE_BUDGET)
     {
-#pragma omp single
+        double *est = (double*)malloc((size_t)total * sizeof(double));
+        if (est)
         {
-#pragma omp taskgroup
+            g_est_nodes = estimate_roots(n, target_length, total, prefix_root, &ctx, est);
+            if (!use_hint_order && !use_cp)
             {
-#pragma omp taskloop grainsize(64) firstprivate(n, target_length, verbose) shared(found, local, cands, total)
                 for (long long i = 0; i < total; ++i)
+                    pl.p[i].score = -(int)(log2(1.0 + est[i]) * 256.0);
+                qsort(pl.p, (size_t)total, sizeof(prefix_t), prefix_cmp);
+            }
+            free(est);
+        }
+    }
+
+    ruler_t res_local;
+    bool found;
+#ifdef _OPENMP
+    if (kernel != dfs_prefix_kernel)
+        found = prefix_taskloop(n, target_length, kernel, &ctx, total, &lane, &res_local);
+    else
+#endif
+    {
+        wp_cp_t h;
+        const wp_cp_t *hooks = cp_pool_hooks(cp, &h);
+        if (verbose && hooks && hooks->nparts > 0)
+            printf("[MP] resuming %lld unfinished parts\n", hooks->nparts);
+        found = wp_solve_lane(n, target_length, total, prefix_root, prefix_root_done, &ctx,
+                              hooks, lane.roots, lane.count, &res_local);
+    }
+
+    cp_close(cp);
+    free(lane.roots);
+    free(pl.p);
+    if (found)
+        *out = res_local;
+    return found;
+}
+
+/* ==================== Speculative L window (-sw) ====================
+ *
+ * The root prefixes of L0 .. L0+nlens-1 in one pool (wp_solve_window):
+ * L0's roots first, so its tail overlaps with the start of L0+1 instead of
+ * idling the team until L0 is proven infeasible.
+ */
+typedef struct {
+    int nlens;
+    const long long *first;
+    const prefix_list_t *pl;    /* one list per L */
+} window_ctx_t;
+
+static bool window_root(void *ctx, long long i, dfs_task_t *t)
+{
+    const window_ctx_t *c = (const window_ctx_t*)ctx;
+    int s = 0;
+    while (s + 1 < c->nlens && i >= c->first[s + 1])
+        ++s;
+    prefix_task(&c->pl[s], i - c->first[s], t);
+    return true;
+}
+
+/* ---------------------------------------------------------------------------
+ * solve_golomb_window_mt -- -mp over the L window L0 .. L0+nlens-1 at once.
+ *
+ * Returns the shortest ruler in the window (every L below it searched in
+ * full), false if none of them has one. The LUT fast lane applies to L0.
+ * --------------------------------------------------------------------------- */
+bool solve_golomb_window_mt(int n, int L0, int nlens, ruler_t *out, bool verbose)
+{
+    if (nlens > L_WINDOW_MAX)
+        nlens = L_WINDOW_MAX;
+    if (L0 + nlens - 1 > MAX_LEN_BITSET)
+        nlens = MAX_LEN_BITSET - L0 + 1;
+    if (n <= 3 || n > MAX_MARKS || nlens <= 1)
+        return solve_golomb_mt(n, L0, out, verbose);
+    init_dispatch();
+
+    const ruler_t *ref = lut_lookup_by_marks(n);
+    bool use_hint_order = ref && !getenv("GOLOMB_NO_HINTS");
+
+    prefix_list_t pl[L_WINDOW_MAX];
+    int lens[L_WINDOW_MAX];
+    long long first[L_WINDOW_MAX + 1];
+    int built = 0;
+    bool ok = true;
+    first[0] = 0;
+    for (int s = 0; s < nlens && ok; ++s)
+    {
+        lens[s] = L0 + s;
+        ok = prefix_build(n, lens[s], 0, wp_num_threads(), 0,
+                          use_hint_order ? ref : NULL, &pl[s]);
+        if (ok)
+            ++built;
+        first[s + 1] = first[s] + (ok ? pl[s].count : 0);
+    }
+    if (verbose && ok)
+        printf("[MP] L=%d..%d: %lld root prefixes in one pool\n",
+               L0, L0 + nlens - 1, first[nlens]);
+
+    bool found = false;
+    if (ok && first[nlens] > 0)
+    {
+        window_ctx_t ctx = { nlens, first, pl };
+        prefix_lane_t lane;
+        prefix_lane_find(&pl[0], use_hint_order ? ref : NULL, &lane);
+        found = wp_solve_window(n, nlens, lens, first, window_root, &ctx,
+                                lane.roots, lane.count, out);
+        free(lane.roots);
+    }
+    for (int s = 0; s < built; ++s)
+        free(pl[s].p);
+    return found;
+}
+
+/* ==================== Exported fan-out (distrib.c) ====================
+ *
+ * The distributed mode splits the same root prefixes across processes: the
+ * coordinator owns the list and its GRCP bitset, workers rebuild the list
+ * from (n, L, depth, hints) -- prefix_build() is deterministic -- and search
+ * index ranges of it on their local pool. With the same depth and hints the
+ * checkpoint is interchangeable with -mp.
+ */
+struct mp_fanout {
+    int n, L;
+    bool hints;
+    prefix_list_t pl;
+    cp_state_t *cp;             /* done-bitset; file only with `checkpoint` */
+};
+
+/* ---------------------------------------------------------------------------
+ * mp_fanout_open -- Root prefixes of (n, L) at depth k (0: adaptive for
+ * `threads` workers), LUT-ordered if `hints` and a LUT ruler exists. With
+ * `checkpoint` and -f, the GRCP file is loaded (a matching file fixes the
+ * depth) and kept up to date. Returns NULL if out of memory or empty.
+ * --------------------------------------------------------------------------- */
+mp_fanout_t *mp_fanout_open(int n, int L, int k, int threads, bool hints, bool checkpoint)
+{
+    if (n <= 3 || n > MAX_MARKS || L > MAX_LEN_BITSET)
+        return NULL;
+    const ruler_t *ref = hints ? lut_lookup_by_marks(n) : NULL;
+    mp_fanout_t *f = (mp_fanout_t*)calloc(1, sizeof *f);
+    if (!f)
+        return NULL;
+    f->n = n;
+    f->L = L;
+    f->hints = (ref != NULL);
+    const char *path = (checkpoint && g_cp_path && *g_cp_path) ? g_cp_path : NULL;
+    cp_key_t key = { n, L, CP_ROOTS_PREFIX, ref ? ref->pos[1] : 0, ref ? ref->pos[2] : 0,
+                     f->hints };
+
+    long long cp_total = cp_peek_total(path, &key);
+    if (!prefix_build(n, L, cp_total > 0 ? 0 : k, threads, cp_total, ref, &f->pl) ||
+        f->pl.count <= 0 ||
+        !(f->cp = cp_open_prefix(path, &key, f->pl.count, prefix_pair, &f->pl)))
+    {
+        free(f->pl.p);
+        free(f);
+        return NULL;
+    }
+    return f;
+}
+
+long long mp_fanout_total(const mp_fanout_t *f) { return f->pl.count; }
+int mp_fanout_depth(const mp_fanout_t *f) { return f->pl.depth; }
+bool mp_fanout_hints(const mp_fanout_t *f) { return f->hints; }
+bool mp_fanout_is_done(const mp_fanout_t *f, long long i) { return cp_is_done(f->cp, i); }
+void mp_fanout_mark_done(mp_fanout_t *f, long long i) { cp_mark_done(f->cp, i); }
+
+/* Roots [lo, hi) of a fan-out as pool roots 0..hi-lo-1. */
+typedef struct {
+    mp_fanout_t *f;
+    long long lo;
+} fanout_range_t;
+
+static bool fanout_range_root(void *ctx, long long i, dfs_task_t *t)
+{
+    const fanout_range_t *r = (const fanout_range_t*)ctx;
+    if (mp_fanout_is_done(r->f, r->lo + i))
+        return false;
+    prefix_task(&r->f->pl, r->lo + i, t);
+    return true;
+}
+
+static void fanout_range_done(void *ctx, long long i)
+{
+    const fanout_range_t *r = (const fanout_range_t*)ctx;
+    mp_fanout_mark_done(r->f, r->lo + i);
+}
+
+/* Searches the roots [lo, hi) on the local pool (stops early on
+ * g_wp_cancel). */
+bool mp_fanout_solve(mp_fanout_t *f, long long lo, long long hi, ruler_t *out)
+{
+    if (lo < 0) lo = 0;
+    if (hi > f->pl.count) hi = f->pl.count;
+    if (lo >= hi)
+        return false;
+    init_dispatch();
+    fanout_range_t r = { f, lo };
+    return wp_solve(f->n, f->L, hi - lo, fanout_range_root, fanout_range_done, &r, out);
+}
+
+void mp_fanout_close(mp_fanout_t *f)
+{
+    if (!f)
+        return;
+    cp_close(f->cp);
+    free(f->pl.p);
+    free(f);
+}
+
+/* ===========================================================================
+ * BRANCH-AND-BOUND OPTIMISATION (-bb)
+ *
+ * Instead of one exhaustive search per length L = start, start+1, ... (each
+ * infeasible L re-walking the same top of the tree), a single search runs
+ * with a shrinking upper bound:
+ *   1. Every ruler shorter than the incumbent is accepted; its length
+ *      becomes the new incumbent and the bound drops to incumbent - 1.
+ *   2. All engines read the incumbent on every commit and clip their open
+ *      frames (dfs_stack_tighten), so one thread's find prunes all others.
+ *   3. When the tree is exhausted the incumbent is optimal.
+ *
+ * The incumbent is a single int updated by compare-and-swap; only the copy
+ * of the winning ruler (rare) is serialised. The parallel variant reuses the
+ * -mp (second, third) fan-out and LUT ordering, so a near-optimal incumbent
+ * shows up early.
+ * =========================================================================== */
+int g_bb_best = 0;
+
+/* Lowers the incumbent to pos[n-1] if it is better; keeps the ruler. */
+static void bb_offer(const int *pos, int n, ruler_t *res, bool verbose)
+{
+    int len = pos[n - 1];
+    int cur = __atomic_load_n(&g_bb_best, __ATOMIC_RELAXED);
+    while (len < cur)
+    {
+        if (__atomic_compare_exchange_n(&g_bb_best, &cur, len, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+#ifdef _OPENMP
+#pragma omp critical(bb_incumbent)
+#endif
+            {
+                /* A later, better find may already have overtaken us. */
+                if (__atomic_load_n(&g_bb_best, __ATOMIC_RELAXED) == len)
                 {
-                    if (found) continue; /* early poll */
+                    res->marks = n;
+                    res->length = len;
+                    memcpy(res->pos, pos, (size_t)n * sizeof(int));
+                }
+            }
+            if (verbose)
+                printf("[BB] incumbent L=%d\n", len);
+            return;
+        }
+    }
+}
 
-                    int second = cands[i].s;
-                    int third  = cands[i].t;
+/* Runs one subtree to exhaustion, offering every ruler it reports. */
+static void bb_search(int depth, int n, const int *pos, const uint64_t *dist_bs,
+                      ruler_t *res, bool verbose)
+{
+    static __thread dfs_stack_t st;
+    dfs_stack_init_bb(&st, depth, n, pos, dist_bs, &g_bb_best, false);
+    while (dfs_stack_run(&st, 0) == DFS_FOUND)
+        bb_offer(st.pos, n, res, verbose);
+}
 
+/* ---------------------------------------------------------------------------
+ * solve_golomb_bb -- Shortest n-mark ruler of length < upper, proven optimal.
+ *
+ * Returns false if no such ruler exists (upper is clamped to the bitset).
+ * --------------------------------------------------------------------------- */
+bool solve_golomb_bb(int n, int upper, ruler_t *out, bool verbose, bool parallel)
+{
+    if (n < 2 || n > MAX_MARKS)
+        return false;
+    if (upper > MAX_LEN_BITSET + 1)
+        upper = MAX_LEN_BITSET + 1;
+    init_dispatch();
+    ruler_t res;
+    res.length = 0;
+    __atomic_store_n(&g_bb_best, upper, __ATOMIC_RELAXED);
+
+#ifdef _OPENMP
+    if (parallel && n > 3)
+    {
+        int U = upper - 1;
+        int second_max = U / 2;                 /* symmetry break */
+        int T = U - (n - 3);                    /* room for n-3 more marks */
+        if (second_max > T - 1) second_max = T - 1;
+
+        long long total = 0;
+        for (int s = 1; s <= second_max; ++s)
+            if (T - s > 0) total += T - s;
+        /* (second, third) pairs packed as s << 16 | t: in hint rings around
+         * the LUT pair (no sort), otherwise lexicographic. */
+        uint32_t *pairs = (total > 0) ? (uint32_t*)malloc((size_t)total * sizeof(uint32_t)) : NULL;
+        if (total > 0 && !pairs)
+            return false;
+
+        const ruler_t *ref = lut_lookup_by_marks(n);
+        int use_hint_order = (ref && !getenv("GOLOMB_NO_HINTS")) ? 1 : 0;
+        long long k = 0;
+        if (use_hint_order)
+        {
+            pair_ring_t ring;
+            pair_ring_init(&ring, ref->pos[1], ref->pos[2], second_max, T);
+            while (k < total && pair_ring_next(&ring, &pairs[k]))
+                ++k;
+        }
+        else
+        {
+            for (int s = 1; s <= second_max; ++s)
+                for (int t = s + 1; t <= T; ++t)
+                    pairs[k++] = (uint32_t)s << 16 | (uint32_t)t;
+        }
+        const int bsw = bs_words_for(U);
+
+#pragma omp parallel
+        {
+#pragma omp single
+            {
+#pragma omp taskloop grainsize(1)
+                for (long long i = 0; i < total; ++i)
+                {
+                    int second = (int)(pairs[i] >> 16);
+                    int third = (int)(pairs[i] & 0xFFFF);
+                    /* Prefix already beaten by the incumbent? */
+                    int b = __atomic_load_n(&g_bb_best, __ATOMIC_RELAXED) - 1;
+                    if (2 * second > b || third + (n - 3) > b)
+                        continue;
+                    int d23 = third - second;
+                    if (d23 == second)
+                        continue;
+                    uint64_t dist_bs[BS_WORDS];
+                    memset(dist_bs, 0, (size_t)bsw * sizeof(uint64_t));
                     int pos[MAX_MARKS];
-                    uint64_t bs[BS_WORDS] = {0};
                     pos[0] = 0;
                     pos[1] = second;
                     pos[2] = third;
-                    set_bit(bs, second);
-                    int d13 = third;
-                    int d23 = third - second;
-                    if (d23 == second || test_bit(bs, d13) || test_bit(bs, d23))
-                        continue;
-                    set_bit(bs, d13);
-                    set_bit(bs, d23);
-                    if (dfs(3, n, target_length, pos, bs, verbose)) {
-                        int old;
-#pragma omp atomic capture
-                        { old = found; found = 1; }
-                        if (old == 0) {
-                            local.marks = n;
-                            local.length = pos[n - 1];
-                            memcpy(local.pos, pos, n * sizeof(int));
-                            /* stop remaining tasks */
-#pragma omp cancel taskgroup
-                        }
-                    }
+                    set_bit(dist_bs, second);
+                    set_bit(dist_bs, third);
+                    set_bit(dist_bs, d23);
+                    bb_search(3, n, pos, dist_bs, &res, verbose);
                 }
-            } /* taskgroup */
-        } /* single */
-    } /* parallel */
-
-    free(cands);
-    if (found)
-    {
-        *out = local;
-        return true;
+            }
+        }
+        free(pairs);
     }
-    return false;
-#else
-    return solve_golomb(n, target_length, out, verbose);
+    else
 #endif
+    {
+        (void)parallel;
+        int pos[MAX_MARKS] = {0};
+        uint64_t dist_bs[BS_WORDS] = {0};
+        bb_search(1, n, pos, dist_bs, &res, verbose);
+    }
 
+    __atomic_store_n(&g_bb_best, 0, __ATOMIC_RELAXED);
+    if (res.length == 0)
+        return false;
+    *out = res;
+    return true;
+}
+
+/* ===========================================================================
+ * DYNAMIC TASK SOLVER (-d)
+ *
+ * Every (second, third) pair becomes a root task of the work-stealing pool
+ * in plain enumeration order: no LUT ordering, no fast lane. Load balance
+ * comes from the pool's splitting of running subtrees, and the pool's stop
+ * flag ends the search after the first hit, so the former
+ * OMP_CANCELLATION=TRUE requirement is gone.
+ *
+ * With -f the run checkpoints like -mp (root bits plus in-flight parts).
+ * The file carries no hints, so it is interchangeable with -mp runs under
+ * GOLOMB_NO_HINTS; a resumed file fixes the prefix depth.
+ * =========================================================================== */
+bool solve_golomb_mt_dyn(int n, int target_length,
+                         ruler_t *out, bool verbose)
+{
+    if (n > MAX_MARKS || target_length > MAX_LEN_BITSET)
+        return false;
+    init_dispatch();
+    if (n <= 3)
+        return solve_golomb(n, target_length, out, verbose);
+
+    cp_key_t key = { n, target_length, CP_ROOTS_PREFIX, 0, 0, 0 };
+    bool use_cp = g_cp_path && *g_cp_path;
+    long long cp_total = use_cp ? cp_peek_total(g_cp_path, &key) : 0;
+
+    /* (second, third) pairs in enumeration order as root tasks. */
+    prefix_list_t pl;
+    if (!prefix_build(n, target_length, cp_total > 0 ? 0 : PREFIX_MIN_DEPTH, 0, cp_total,
+                      NULL, &pl))
+        return false;
+    cp_state_t *cp = NULL;
+    if (use_cp && pl.count > 0 &&
+        !(cp = cp_open_prefix(g_cp_path, &key, pl.count, prefix_pair, &pl)))
+    {
+        free(pl.p);
+        return false;
+    }
+    prefix_ctx_t ctx = { &pl, cp };
+    wp_cp_t h;
+    bool found = wp_solve_cp(n, target_length, pl.count, prefix_root, prefix_root_done, &ctx,
+                             cp_pool_hooks(cp, &h), out);
+    cp_close(cp);
+    free(pl.p);
+    return found;
 }
 
@@ -0,0 +1,172 @@
+/* ==========================================================================
+ * SOLVER_ENUM.C — Enumerate All Rulers of a Given Length (-ea)
+ * ==========================================================================
+ *
+ * The search solvers stop at the first ruler (shared `found` flag, task
+ * cancellation). This mode never cancels: every subtree is run to
+ * exhaustion on the iterative dfs() engine, which is resumable after each
+ * DFS_FOUND, so the whole solution set for (n, L) comes out.
+ *
+ * Mirror images:
+ *   Reversing a ruler (p -> L - p) gives another ruler of the same length.
+ *   For n >= 3 the two first gaps pos[1] and L - pos[n-2] always differ
+ *   (equal would repeat a distance), so exactly one of the pair has the
+ *   smaller first gap. Only that one is reported; it satisfies the engine's
+ *   symmetry break pos[1] <= L/2, so nothing is lost.
+ *
+ * Parallelism:
+ *   Same (second, third) prefix fan-out as -mp, scheduled dynamically, with
+ *   the solution count aggregated by an OpenMP reduction. Each thread
+ *   formats rulers into a private buffer; only a full buffer takes the sink
+ *   lock, so there is no serialising step per solution.
+ * ========================================================================== */
+
+#include "golomb.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Bitset helper (duplicated here for compilation-unit locality). */
+static inline void set_bit(uint64_t *bs, int idx) { bs[idx >> 6] |= 1ULL << (idx & 63); }
+
+#define ENUM_BUF_SIZE  (64 * 1024)
+#define ENUM_LINE_MAX  (MAX_MARKS * 4 + 2)   /* "ddd " per mark + newline */
+
+/* Per-thread output buffer in front of the shared sink. */
+typedef struct {
+    FILE *sink;
+    size_t len;
+    char buf[ENUM_BUF_SIZE];
+} enum_buf_t;
+
+static __thread enum_buf_t g_enum_buf;
+
+static void enum_flush(enum_buf_t *b)
+{
+    if (b->sink && b->len)
+    {
+#ifdef _OPENMP
+#pragma omp critical(enum_sink)
+#endif
+        fwrite(b->buf, 1, b->len, b->sink);
+    }
+    b->len = 0;
+}
+
+/* Appends "p0 p1 ... p(n-1)\n" to the buffer. */
+static void enum_emit(enum_buf_t *b, const int *pos, int n)
+{
+    if (!b->sink)
+        return;
+    if (b->len + ENUM_LINE_MAX > sizeof b->buf)
+        enum_flush(b);
+    char *p = b->buf + b->len;
+    for (int i = 0; i < n; ++i)
+    {
+        char tmp[12];
+        int k = 0;
+        unsigned v = (unsigned)pos[i];
+        do { tmp[k++] = (char)('0' + v % 10); v /= 10; } while (v);
+        while (k)
+            *p++ = tmp[--k];
+        *p++ = (i == n - 1) ? '\n' : ' ';
+    }
+    b->len = (size_t)(p - b->buf);
+}
+
+/* Runs one subtree to exhaustion; returns the number of canonical rulers. */
+static long long enum_subtree(int depth, int n, int L, const int *pos,
+                              const uint64_t *dist_bs, enum_buf_t *b)
+{
+    static __thread dfs_stack_t st;
+    long long count = 0;
+    dfs_stack_init(&st, depth, n, L, pos, dist_bs, false);
+    while (dfs_stack_run(&st, 0) == DFS_FOUND)
+    {
+        /* Keep the mirror pair member with the smaller first gap. */
+        if (n >= 3 && st.pos[1] > L - st.pos[n - 2])
+            continue;
+        ++count;
+        enum_emit(b, st.pos, n);
+    }
+    return count;
+}
+
+/* ---------------------------------------------------------------------------
+ * enumerate_golomb -- Counts all n-mark rulers of length exactly L (mirror
+ * images once) and writes each to `sink` (one line of positions; NULL: count
+ * only). `parallel` uses the OpenMP prefix fan-out. Returns -1 if out of
+ * memory.
+ * --------------------------------------------------------------------------- */
+long long enumerate_golomb(int n, int L, FILE *sink, bool parallel)
+{
+    if (n < 2 || n > MAX_MARKS || L < 1 || L > MAX_LEN_BITSET)
+        return 0;
+    long long count = 0;
+
+#ifdef _OPENMP
+    if (parallel && n > 3)
+    {
+        int second_max = L / 2;             /* symmetry break */
+        int T = L - (n - 3);                /* room for n-3 more marks */
+        if (second_max > T - 1) second_max = T - 1;
+        const int bsw = bs_words_for(L);        /* live bitset words */
+
+        /* One work unit per valid (second, third) prefix. */
+        long long total = 0;
+        for (int s = 1; s <= second_max; ++s)
+            if (T - s > 0) total += T - s;
+        int *pairs = (total > 0) ? (int*)malloc((size_t)total * 2 * sizeof(int)) : NULL;
+        if (total > 0 && !pairs)
+            return -1;
+        long long k = 0;
+        for (int s = 1; s <= second_max; ++s)
+            for (int t = s + 1; t <= T; ++t)
+            {
+                pairs[2 * k] = s;
+                pairs[2 * k + 1] = t;
+                ++k;
+            }
+
+#pragma omp parallel reduction(+:count)
+        {
+            enum_buf_t *b = &g_enum_buf;
+            b->sink = sink;
+            b->len = 0;
+#pragma omp for schedule(dynamic, 1)
+            for (long long i = 0; i < total; ++i)
+            {
+                int second = pairs[2 * i];
+                int third = pairs[2 * i + 1];
+                if (third - second == second)
+                    continue;
+                uint64_t dist_bs[BS_WORDS];
+                memset(dist_bs, 0, (size_t)bsw * sizeof(uint64_t));
+                int pos[MAX_MARKS];
+                pos[0] = 0;
+                pos[1] = second;
+                pos[2] = third;
+                set_bit(dist_bs, second);
+                set_bit(dist_bs, third);
+                set_bit(dist_bs, third - second);
+                count += enum_subtree(3, n, L, pos, dist_bs, b);
+            }
+            enum_flush(b);
+        }
+        free(pairs);
+        return count;
+    }
+#endif
+    (void)parallel;
+    enum_buf_t *b = &g_enum_buf;
+    b->sink = sink;
+    b->len = 0;
+    int pos[MAX_MARKS] = {0};
+    uint64_t dist_bs[BS_WORDS] = {0};
+    count = enum_subtree(1, n, L, pos, dist_bs, b);
+    enum_flush(b);
+    return count;
+}
@@ -0,0 +1,210 @@
+/* ==========================================================================
+ * SOLVER_SHIFT.C — Bit-Parallel Shift-Register Engine (-sr)
+ * ==========================================================================
+ *
+ * Idea:
+ *   dfs() in solver.c tests every candidate `next` one by one: it computes
+ *   `depth` distances and probes the distance bitset for each of them. This
+ *   engine instead keeps the whole partial ruler as bit registers relative to
+ *   the LAST placed mark and handles all distances of a candidate with a few
+ *   word-wide shift/AND/OR operations:
+ *
+ *     list  bit o set  <=>  a mark sits o positions left of the last mark
+ *                           (bit 0 is the last mark itself)
+ *     dist  bit d set  <=>  distance d is already measured (same as dist_bs)
+ *     comp  bit g set  <=>  next gap g is known to be forbidden
+ *
+ *   Placing the next mark at gap g creates exactly the distances (list << g),
+ *   so the candidate is legal iff ((list << g) & dist) == 0, and committing it
+ *   is a single OR. The registers for the child are
+ *
+ *     list' = (list << g) | 1
+ *     dist' = dist | (list << g)
+ *     comp' = (comp >> g) | dist'
+ *
+ *   comp' is the classic shift-register "forbidden gap" update: every bit it
+ *   contains is truly forbidden, so all remaining candidates come out of one
+ *   mask (~comp) and are walked with count-trailing-zeros. It may miss a few
+ *   forbidden gaps (constraints between older marks and distances added after
+ *   them), which the exact (list << g) & dist test catches. At the prefix
+ *   root comp is computed exactly.
+ *
+ * Parallelism:
+ *   The engine is a subtree kernel for solve_golomb_prefix_mt(), i.e. it
+ *   reuses the -mp (second, third) fan-out including LUT ordering, the fast
+ *   lane and checkpointing. The recursion cannot be split like the dfs()
+ *   stack, so each candidate stays one OpenMP task instead of going to the
+ *   work-stealing pool.
+ *
+ * Register width:
+ *   Only the first (L >> 6) + 1 words of each register are live, so for the
+ *   usual orders (L < 256) every operation touches at most four words.
+ * ========================================================================== */
+
+#include "golomb.h"
+#include <string.h>
+#include <stdint.h>
+
+/* Per-level register file. Each level owns a copy so backtracking is free. */
+typedef struct {
+    int n;
+    int L;
+    int nw;                              /* live words per register */
+    int *pos;
+    uint64_t list[MAX_MARKS][BS_WORDS];
+    uint64_t dist[MAX_MARKS][BS_WORDS];
+    uint64_t comp[MAX_MARKS][BS_WORDS];
+} shift_state_t;
+
+/* Word i of (src << g) over nw words. */
+static inline uint64_t shl_word(const uint64_t *src, int g, int i)
+{
+    int j = i - (g >> 6);
+    int b = g & 63;
+    uint64_t v = (j >= 0) ? src[j] << b : 0;
+    if (b && j >= 1)
+        v |= src[j - 1] >> (64 - b);
+    return v;
+}
+
+/* Word i of (src >> g) over nw words. */
+static inline uint64_t shr_word(const uint64_t *src, int g, int i, int nw)
+{
+    int j = i + (g >> 6);
+    int b = g & 63;
+    uint64_t v = (j < nw) ? src[j] >> b : 0;
+    if (b && j + 1 < nw)
+        v |= src[j + 1] << (64 - b);
+    return v;
+}
+
+/* Exact legality test: does any new distance (list << g) collide with dist? */
+static inline int shl_and_any(const uint64_t *list, int g, const uint64_t *dist, int nw)
+{
+    for (int i = g >> 6; i < nw; ++i)
+        if (shl_word(list, g, i) & dist[i])
+            return 1;
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * shift_search -- Recursive search below a node whose registers are stored
+ * at level `depth` (marks pos[0..depth-1] placed, last one at `last`).
+ * --------------------------------------------------------------------------- */
+static bool shift_search(shift_state_t *st, int depth, int last)
+{
+    const int n = st->n;
+    const int L = st->L;
+    const int nw = st->nw;
+
+    /* Lower bound: even with minimum gaps of 1, can we still reach L? */
+    if (last + (n - depth) > L)
+        return false;
+
+    const uint64_t *list = st->list[depth];
+    const uint64_t *dist = st->dist[depth];
+    const uint64_t *comp = st->comp[depth];
+
+    /* Gap range: leave room for (n-depth-1) more marks; the final mark must
+     * land exactly on L. */
+    int gmax = L - (n - depth - 1) - last;
+    int gmin = (depth == n - 1) ? gmax : 1;
+
+    /* Sub-ruler bounds from the LUT (bounds.c). */
+    int lo = last + gmin;
+    int hi = last + gmax;
+    if (!bounds_next_range(depth, n, L, st->pos, &lo, &hi))
+        return false;
+    gmin = lo - last;
+    gmax = hi - last;
+
+    for (int w = gmin >> 6; w <= gmax >> 6; ++w)
+    {
+        uint64_t cand = ~comp[w];
+        if (w == (gmin >> 6))
+            cand &= ~0ULL << (gmin & 63);
+        if (w == (gmax >> 6))
+            cand &= ~0ULL >> (63 - (gmax & 63));
+
+        while (cand)
+        {
+            int g = (w << 6) + __builtin_ctzll(cand);
+            cand &= cand - 1;
+
+            if (shl_and_any(list, g, dist, nw))
+                continue;
+
+            st->pos[depth] = last + g;
+            if (depth == n - 1)
+                return true;
+
+            /* Commit into the child level's registers. */
+            uint64_t *nl = st->list[depth + 1];
+            uint64_t *nd = st->dist[depth + 1];
+            uint64_t *nc = st->comp[depth + 1];
+            for (int i = 0; i < nw; ++i)
+            {
+                uint64_t add = shl_word(list, g, i);
+                nl[i] = add;
+                nd[i] = dist[i] | add;
+                nc[i] = shr_word(comp, g, i, nw) | nd[i];
+            }
+            nl[0] |= 1ULL;
+
+            if (shift_search(st, depth + 1, last + g))
+                return true;
+        }
+    }
+    return false;
+}
+
+/* ---------------------------------------------------------------------------
+ * dfs_shift -- Prefix kernel: pos[0..depth-1] and dist_bs describe the prefix.
+ *
+ * Builds the registers of the prefix root (comp computed exactly from all
+ * placed marks) and searches the subtree. On success pos[] holds the ruler.
+ * --------------------------------------------------------------------------- */
+bool dfs_shift(int depth, int n, int target_len, int *pos, uint64_t *dist_bs)
+{
+    shift_state_t st;
+    bounds_init();
+    st.n = n;
+    st.L = target_len;
+    st.nw = (target_len >> 6) + 1;
+    st.pos = pos;
+
+    if (depth >= n)
+        return pos[n - 1] == target_len;
+
+    int last = pos[depth - 1];
+    uint64_t *list = st.list[depth];
+    uint64_t *dist = st.dist[depth];
+    uint64_t *comp = st.comp[depth];
+    memset(list, 0, sizeof st.list[depth]);
+    memcpy(dist, dist_bs, (size_t)st.nw * sizeof(uint64_t));
+    for (int i = 0; i < depth; ++i)
+    {
+        int o = last - pos[i];
+        list[o >> 6] |= 1ULL << (o & 63);
+    }
+    for (int w = 0; w < st.nw; ++w)
+        comp[w] = 0;
+    for (int i = 0; i < depth; ++i)
+    {
+        int o = last - pos[i];
+        for (int w = 0; w < st.nw; ++w)
+            comp[w] |= shr_word(dist, o, w, st.nw);
+    }
+
+    return shift_search(&st, depth, last);
+}
+
+/* ---------------------------------------------------------------------------
+ * solve_golomb_shift -- Public entry point (-sr).
+ *
+ * Runs the shift-register kernel under the -mp prefix fan-out.
+ * --------------------------------------------------------------------------- */
+bool solve_golomb_shift(int n, int target_length, ruler_t *out, bool verbose)
+{
+    return solve_golomb_prefix_mt(n, target_length, out, verbose, dfs_shift);
+}
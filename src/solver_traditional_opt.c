@@ -25,12 +25,23 @@
  * Complexity:
  *   Worst-case exponential (exhaustive search over all mark placements),
  *   but the constant factor is significantly reduced by early pruning.
+ *
+ * Checkpointing (-f):
+ *   The search runs as one root per second mark (root i: pos[1] = i + 1),
+ *   recorded in a GRCP file of kind CP_ROOTS_ENDPOINT. Every -fi seconds the
+ *   frame stack is saved as parts (prefix plus untried range per open
+ *   frame, as dfs_stack_remaining does for the pool), together with the
+ *   resumed parts not started yet. A resumed run searches the saved parts
+ *   first and skips their roots.
  * ========================================================================== */
 
+#define _POSIX_C_SOURCE 200809L   /* clock_gettime */
 #include "golomb.h"
 #include <string.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 
 /* Bitset manipulation helpers for the distance tracking bitset. */
 static inline void set_bit(uint64_t *bs, int idx) { bs[idx >> 6] |= 1ULL << (idx & 63); }
@@ -38,13 +49,17 @@ static inline void clr_bit(uint64_t *bs, int idx) { bs[idx >> 6] &= ~(1ULL << (i
 static inline int  test_bit(const uint64_t *bs, int idx) { return (bs[idx >> 6] >> (idx & 63)) & 1ULL; }
 
 /* ---------------------------------------------------------------------------
- * dfs_endpoint -- Recursive DFS that places inner marks (indices 1..n-2).
+ * dfs_endpoint -- Iterative DFS that places inner marks (indices 1..n-2).
  *
  * Preconditions:
  *   - pos[0] = 0 and pos[n-1] = L are already fixed.
  *   - The distance L (between the two endpoints) is already set in dist_bs.
  *   - Marks are placed in ascending order: pos[depth] > pos[depth-1].
  *
+ * The search walks an explicit stack of dfs_frame_t (see golomb.h): each
+ * frame keeps its candidate cursor, its bound and the distances it
+ * committed (left-side distances plus d_end in slot `depth`).
+ *
  * For each candidate position `next`:
  *   1. Check the gap to the previous mark (quick scalar test).
  *   2. Check the distance to the FIXED endpoint: d_end = L - next.
@@ -52,16 +67,12 @@ static inline int  test_bit(const uint64_t *bs, int idx) { return (bs[idx >> 6]
  *      fail much later in the standard solver.
  *   3. Check all distances to previously placed left-side marks.
  *   4. Check for intra-step collision (a left distance equals d_end).
- *   5. If all checks pass, commit distances and recurse.
+ *   5. If all checks pass, commit distances and descend.
  * --------------------------------------------------------------------------- */
-static bool dfs_endpoint(int depth, int n, int L,
-                         int *pos, uint64_t *dist_bs, bool verbose)
-{
-    /* All inner marks placed -> the ruler is complete and valid. */
-    if (depth == n - 1) {
-        return true;
-    }
 
+/* Set up the frame for inner mark `depth`. */
+static inline void endpoint_enter(dfs_frame_t *f, int depth, int n, int L, const int *pos)
+{
     int last = pos[depth - 1];
 
     /* Upper bound for `next`: after placing it, we still need (n-2-depth)
@@ -76,10 +87,101 @@ static bool dfs_endpoint(int depth, int n, int L,
         if (limit < last + 1) limit = last + 1;
         if (max_next > limit) max_next = limit;
     }
+    int lo = last + 1;
+
+    /* Sub-ruler bounds from the LUT (bounds.c): the marks depth..n-1 end at
+     * the fixed endpoint, so the same suffix/window cuts apply. */
+    if (!bounds_next_range(depth, n, L, pos, &lo, &max_next) ||
+        !bounds_gap_sum_range(last, L, f->gap_sum, f->gap_thr, &lo, &max_next)) {
+        f->next = 1;
+        f->max_next = 0;
+        return;
+    }
+    f->next = lo;
+    f->max_next = max_next;
+}
+
+/* Checkpoint state of one run: the part being searched and the resumed
+ * parts still queued behind it. */
+typedef struct {
+    cp_state_t *cp;
+    long long root;             /* root of the running part */
+    const wp_part_t *queued;
+    long long nqueued;
+    long long ticks;
+    struct timespec last_save;
+    int interval;
+} endpoint_cp_t;
+
+#define ENDPOINT_CP_TICKS 0xFFFF  /* candidates between clock reads */
+
+/* Saves the untried work: frames base..depth of the running part, then the
+ * queued parts. */
+static void endpoint_save(endpoint_cp_t *c, const dfs_frame_t *frame, int base, int depth,
+                          const int *pos)
+{
+    long long cap = MAX_MARKS + c->nqueued;
+    wp_part_t *parts = (wp_part_t*)malloc((size_t)cap * sizeof(wp_part_t));
+    if (!parts)
+        return;
+    long long count = 0;
+    for (int d = depth; d >= base; --d)
+    {
+        if (frame[d].next > frame[d].max_next)
+            continue;
+        wp_part_t *p = &parts[count++];
+        p->root = c->root;
+        p->t.depth = d;
+        p->t.lo = frame[d].next;
+        p->t.hi = frame[d].max_next;
+        memcpy(p->t.pos, pos, (size_t)d * sizeof(int));
+    }
+    for (long long k = 0; k < c->nqueued; ++k)
+        parts[count++] = c->queued[k];
+    cp_save_parts(c->cp, parts, count);
+    free(parts);
+}
 
-    int new_dists[MAX_MARKS]; /* Temporary storage for distances from `next` */
+/* Searches inner marks base..n-2 below pos[0..base-1] (dist_bs holds their
+ * distances and those to L), mark `base` restricted to [lo, hi]. */
+static bool dfs_endpoint(int n, int L, int *pos, uint64_t *dist_bs, bool verbose,
+                         int base, int lo, int hi, endpoint_cp_t *cp)
+{
+    /* All inner marks placed -> the ruler is complete and valid. */
+    if (n <= 2)
+        return true;
+
+    static __thread dfs_frame_t frame[MAX_MARKS];
+    int depth = base;
+    frame[depth].gap_sum = bounds_gap_sum_scan(dist_bs, n - depth, &frame[depth].gap_thr);
+    endpoint_enter(&frame[depth], depth, n, L, pos);
+    if (frame[depth].next < lo) frame[depth].next = lo;
+    if (frame[depth].max_next > hi) frame[depth].max_next = hi;
+
+    for (;;) {
+        if (cp && (++cp->ticks & ENDPOINT_CP_TICKS) == 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (now.tv_sec - cp->last_save.tv_sec >= cp->interval) {
+                endpoint_save(cp, frame, base, depth, pos);
+                cp->last_save = now;
+            }
+        }
+        dfs_frame_t *f = &frame[depth];
+        if (f->next > f->max_next) {
+            if (depth == base)
+                return false;
+            /* Pop and roll back: undo all distances added by the parent. */
+            --depth;
+            const int *pd = frame[depth].dists;
+            for (int i = 0; i <= depth; ++i)
+                clr_bit(dist_bs, pd[i]);
+            continue;
+        }
+
+        int next = f->next++;
+        int last = pos[depth - 1];
 
-    for (int next = last + 1; next <= max_next; ++next) {
         /* Quick check: distance to immediate predecessor. */
         int gap = next - last;
         if (test_bit(dist_bs, gap))
@@ -92,6 +194,7 @@ static bool dfs_endpoint(int depth, int n, int L,
             continue;
 
         /* Check all distances from `next` to previously placed left marks. */
+        int *new_dists = f->dists;
         bool ok = true;
         for (int i = 0; i < depth; ++i) {
             int d = next - pos[i];
@@ -113,29 +216,53 @@ static bool dfs_endpoint(int depth, int n, int L,
 
         /* Commit: set all new distances (left-side + endpoint). */
         pos[depth] = next;
-        for (int i = 0; i < depth; ++i)
+        new_dists[depth] = d_end;
+        for (int i = 0; i <= depth; ++i)
             set_bit(dist_bs, new_dists[i]);
-        set_bit(dist_bs, d_end);
+
+        /* Distinct-gap bound of the child, updated incrementally (bounds.c). */
+        dfs_frame_t *c = &frame[depth + 1];
+        c->gap_sum = f->gap_sum;
+        c->gap_thr = f->gap_thr;
+        bounds_gap_sum_child(dist_bs, n - depth - 1, new_dists, depth + 1, &c->gap_sum, &c->gap_thr);
 
         if (verbose && depth < 6)
             printf("[TRAD-OPT] depth %d add %d (d_end=%d)\n", depth, next, d_end);
 
-        if (dfs_endpoint(depth + 1, n, L, pos, dist_bs, verbose))
+        if (depth + 1 == n - 1)
             return true;
-
-        /* Rollback: undo all distances added in this step. */
-        for (int i = 0; i < depth; ++i)
-            clr_bit(dist_bs, new_dists[i]);
-        clr_bit(dist_bs, d_end);
+        ++depth;
+        endpoint_enter(&frame[depth], depth, n, L, pos);
     }
+}
 
-    return false;
+/* Sets up the search of a part: pos[0..depth-1] and L placed, all their
+ * distances in dist_bs. False if the prefix repeats a distance. */
+static bool endpoint_prefix(int n, int L, const dfs_task_t *t, int *pos, uint64_t *dist_bs)
+{
+    if (t->depth < 1 || t->depth > n - 2)
+        return false;
+    memset(dist_bs, 0, BS_WORDS * sizeof(uint64_t));
+    memcpy(pos, t->pos, (size_t)t->depth * sizeof(int));
+    pos[n - 1] = L;
+    for (int j = 0; j < t->depth; ++j) {
+        for (int i = 0; i < j; ++i) {
+            int d = pos[j] - pos[i];
+            if (d <= 0 || test_bit(dist_bs, d)) return false;
+            set_bit(dist_bs, d);
+        }
+        int d_end = L - pos[j];
+        if (d_end <= 0 || test_bit(dist_bs, d_end)) return false;
+        set_bit(dist_bs, d_end);
+    }
+    return true;
 }
 
 /* ---------------------------------------------------------------------------
  * solve_golomb_traditional_opt -- Public entry point.
  *
- * Sets up the fixed endpoints and launches the endpoint-aware DFS.
+ * Sets up the fixed endpoints and launches the endpoint-aware DFS, one root
+ * per second mark (resumable with -f, see the header).
  * Returns true if a valid n-mark ruler of exactly `target_length` exists.
  * --------------------------------------------------------------------------- */
 bool solve_golomb_traditional_opt(int n, int target_length, ruler_t *out, bool verbose)
@@ -147,6 +274,7 @@ bool solve_golomb_traditional_opt(int n, int target_length, ruler_t *out, bool v
         return false;
     }
 
+    bounds_init();
     int pos[MAX_MARKS] = {0};
     uint64_t dist_bs[BS_WORDS] = {0};
 
@@ -154,11 +282,70 @@ bool solve_golomb_traditional_opt(int n, int target_length, ruler_t *out, bool v
     pos[0] = 0;
     pos[n - 1] = target_length;
 
-    /* The distance between the two endpoints (L itself) is immediately used. */
-    set_bit(dist_bs, target_length);
+    /* Roots: one per second mark 1 .. max(L/2, 1) (symmetry break). */
+    long long total = (target_length / 2 > 1) ? target_length / 2 : 1;
+    cp_state_t *cp = NULL;
+    if (n > 2 && g_cp_path && *g_cp_path) {
+        cp_key_t key = { n, target_length, CP_ROOTS_ENDPOINT, 0, 0, 0 };
+        cp = cp_open(g_cp_path, &key, total);
+        if (!cp)
+            return false;
+    }
+    endpoint_cp_t run;
+    memset(&run, 0, sizeof run);
+    run.cp = cp;
+    run.interval = (g_cp_interval_sec > 0) ? g_cp_interval_sec : 60;
+    clock_gettime(CLOCK_MONOTONIC, &run.last_save);
+
+    const wp_part_t *parts = NULL;
+    long long nparts = 0;
+    int *open = NULL;               /* resumed parts outstanding per root */
+    if (cp) {
+        parts = cp_resume_parts(cp, &nparts);
+        if (nparts > 0 && !(open = (int*)calloc((size_t)total, sizeof(int)))) {
+            cp_close(cp);
+            return false;
+        }
+        for (long long k = 0; k < nparts; ++k)
+            ++open[parts[k].root];
+    }
 
-    /* Search for n-2 inner marks between 1 and L-1. */
-    if (!dfs_endpoint(1, n, target_length, pos, dist_bs, verbose))
+    bool found = false;
+    if (n <= 2) {
+        found = dfs_endpoint(n, target_length, pos, dist_bs, verbose, 1, 1, 0, NULL);
+    } else {
+        /* Resumed parts first; their roots are marked done when the last part
+         * of each finishes, so the root loop below skips them. */
+        for (long long k = 0; k < nparts && !found; ++k) {
+            run.root = parts[k].root;
+            run.queued = parts + k + 1;
+            run.nqueued = nparts - k - 1;
+            if (endpoint_prefix(n, target_length, &parts[k].t, pos, dist_bs))
+                found = dfs_endpoint(n, target_length, pos, dist_bs, verbose, parts[k].t.depth,
+                                     parts[k].t.lo, parts[k].t.hi, &run);
+            if (!found && --open[parts[k].root] == 0)
+                cp_mark_done(cp, parts[k].root);
+        }
+        run.queued = NULL;
+        run.nqueued = 0;
+        for (long long i = 0; i < total && !found; ++i) {
+            if (cp && cp_is_done(cp, i))
+                continue;
+            dfs_task_t t;
+            t.depth = 1;
+            t.pos[0] = 0;
+            t.lo = t.hi = (int)i + 1;
+            run.root = i;
+            endpoint_prefix(n, target_length, &t, pos, dist_bs);
+            found = dfs_endpoint(n, target_length, pos, dist_bs, verbose, 1, t.lo, t.hi,
+                                 cp ? &run : NULL);
+            if (!found && cp)
+                cp_mark_done(cp, i);
+        }
+    }
+    free(open);
+    cp_close(cp);
+    if (!found)
         return false;
 
     out->marks = n;
@@ -0,0 +1,178 @@
+/* ==========================================================================
+ * STATS.C — Per-Depth Node and Prune Counters (make STATS=1)
+ * ==========================================================================
+ *
+ * The dfs() engine counts, per thread,
+ *
+ *   nodes[d]            marks placed at index d (leaves included),
+ *   cut[STAT_PRE_GAP]   candidates rejected by the gap-to-previous pre-check,
+ *   cut[STAT_DUP]       candidates rejected by the full duplicate test,
+ *   cut[STAT_BOUND]     candidates clipped from a new frame's range by the
+ *                       G(k) and distinct-gap bounds.
+ *
+ * Every thread owns one cache-line aligned slot, so the hot path is a plain
+ * increment without sharing or locked instructions. Readers (heartbeat,
+ * final report) sum the slots with relaxed loads. When a thread exits, its
+ * slot is folded into a retired total and reused, so the per-L pthread
+ * pools do not run out of slots.
+ *
+ * The counters are never reset: they cover the whole process (every L of a
+ * sweep, every -sw window), like the elapsed time the final report divides
+ * by. A -worker process prints no report.
+ *
+ * Without GOLOMB_STATS the counters do not exist: STAT_ADD() expands to
+ * nothing and this file is empty.
+ * ========================================================================== */
+
+#ifdef GOLOMB_STATS
+
+#include "golomb.h"
+#include <pthread.h>
+#include <string.h>
+
+#define STATS_MAX_SLOTS 256
+
+__thread search_stats_t *g_stats_tls;
+
+static search_stats_t g_slots[STATS_MAX_SLOTS];
+static bool g_slot_used[STATS_MAX_SLOTS];
+static search_stats_t g_retired;       /* counts of exited threads */
+static search_stats_t g_overflow;      /* shared by threads beyond the slots */
+static pthread_mutex_t g_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t g_stats_key;
+static pthread_once_t g_stats_once = PTHREAD_ONCE_INIT;
+
+static void stats_add(search_stats_t *dst, const search_stats_t *src)
+{
+    for (int d = 0; d < MAX_MARKS; ++d)
+        dst->nodes[d] += __atomic_load_n(&src->nodes[d], __ATOMIC_RELAXED);
+    for (int k = 0; k < STAT_KINDS; ++k)
+        dst->cut[k] += __atomic_load_n(&src->cut[k], __ATOMIC_RELAXED);
+}
+
+/* Thread exit: keep the counts, free the slot. */
+static void stats_release(void *p)
+{
+    search_stats_t *s = p;
+    pthread_mutex_lock(&g_stats_lock);
+    stats_add(&g_retired, s);
+    memset(s, 0, sizeof *s);
+    g_slot_used[s - g_slots] = false;
+    pthread_mutex_unlock(&g_stats_lock);
+}
+
+static void stats_key_init(void)
+{
+    pthread_key_create(&g_stats_key, stats_release);
+}
+
+/* ---------------------------------------------------------------------------
+ * stats_claim -- Slow path of stats_local(): bind a free slot to the calling
+ * thread. Beyond STATS_MAX_SLOTS live threads the extras share one slot
+ * (counts may then be slightly low).
+ * --------------------------------------------------------------------------- */
+search_stats_t *stats_claim(void)
+{
+    pthread_once(&g_stats_once, stats_key_init);
+    search_stats_t *s = &g_overflow;
+    pthread_mutex_lock(&g_stats_lock);
+    for (int i = 0; i < STATS_MAX_SLOTS; ++i)
+    {
+        if (!g_slot_used[i])
+        {
+            g_slot_used[i] = true;
+            s = &g_slots[i];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_stats_lock);
+    if (s != &g_overflow)
+        pthread_setspecific(g_stats_key, s);
+    g_stats_tls = s;
+    return s;
+}
+
+/* Sum over all threads (live and exited); safe while searches run. */
+void stats_sum(search_stats_t *out)
+{
+    memset(out, 0, sizeof *out);
+    pthread_mutex_lock(&g_stats_lock);
+    stats_add(out, &g_retired);
+    stats_add(out, &g_overflow);
+    for (int i = 0; i < STATS_MAX_SLOTS; ++i)
+        if (g_slot_used[i])
+            stats_add(out, &g_slots[i]);
+    pthread_mutex_unlock(&g_stats_lock);
+}
+
+/* Total nodes and the candidates examined (placed or dropped). */
+static void stats_totals(const search_stats_t *s, double *nodes, double *cand)
+{
+    double t = 0.0;
+    for (int d = 0; d < MAX_MARKS; ++d)
+        t += (double)s->nodes[d];
+    *nodes = t;
+    for (int k = 0; k < STAT_KINDS; ++k)
+        t += (double)s->cut[k];
+    *cand = (t > 0.0) ? t : 1.0;
+}
+
+/* Prints the counters collected so far (like bounds_report). */
+void stats_report(FILE *fp, double seconds)
+{
+    search_stats_t s;
+    double nodes, cand;
+    stats_sum(&s);
+    stats_totals(&s, &nodes, &cand);
+    fprintf(fp, "[Stats] %.0f nodes, %.3g nodes/s, pruned: gap %.1f%% dup %.1f%% bound %.1f%%\n",
+            nodes, seconds > 0.0 ? nodes / seconds : 0.0,
+            100.0 * s.cut[STAT_PRE_GAP] / cand, 100.0 * s.cut[STAT_DUP] / cand,
+            100.0 * s.cut[STAT_BOUND] / cand);
+    fprintf(fp, "[Stats] nodes per depth:");
+    for (int d = 1; d < MAX_MARKS; ++d)
+        if (s.nodes[d])
+            fprintf(fp, " %d:%llu", d, s.nodes[d]);
+    fprintf(fp, "\n");
+}
+
+/* ---------------------------------------------------------------------------
+ * stats_tick -- Heartbeat line: node rate since the previous tick (and over
+ * the whole run, `now` seconds) plus the prune ratios so far. Only the
+ * heartbeat thread calls it.
+ * --------------------------------------------------------------------------- */
+void stats_tick(FILE *fp, double now)
+{
+    static double prev_nodes, prev_t;
+    search_stats_t s;
+    double nodes, cand;
+    stats_sum(&s);
+    stats_totals(&s, &nodes, &cand);
+    double dt = now - prev_t;
+    double rate = (dt > 0.0 && nodes >= prev_nodes) ? (nodes - prev_nodes) / dt : 0.0;
+    fprintf(fp, "[VT] %.3g nodes/s (avg %.3g) – pruned: gap %.1f%% dup %.1f%% bound %.1f%%\n",
+            rate, now > 0.0 ? nodes / now : 0.0,
+            100.0 * s.cut[STAT_PRE_GAP] / cand, 100.0 * s.cut[STAT_DUP] / cand,
+            100.0 * s.cut[STAT_BOUND] / cand);
+    prev_nodes = nodes;
+    prev_t = now;
+}
+
+/* Same as key=value lines for the result file. */
+void stats_write(FILE *fp, double seconds)
+{
+    search_stats_t s;
+    double nodes, cand;
+    stats_sum(&s);
+    stats_totals(&s, &nodes, &cand);
+    int top = MAX_MARKS - 1;
+    while (top > 1 && !s.nodes[top])
+        --top;
+    fprintf(fp, "nodes=%.0f\nnodes_per_sec=%.0f\nnodes_by_depth=", nodes,
+            seconds > 0.0 ? nodes / seconds : 0.0);
+    for (int d = 1; d <= top; ++d)
+        fprintf(fp, "%llu%s", s.nodes[d], (d == top) ? "" : " ");
+    fprintf(fp, "\nprune_gap=%.4f\nprune_dup=%.4f\nprune_bound=%.4f\n",
+            s.cut[STAT_PRE_GAP] / cand, s.cut[STAT_DUP] / cand, s.cut[STAT_BOUND] / cand);
+}
+
+#endif /* GOLOMB_STATS */
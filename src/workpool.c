@@ -0,0 +1,854 @@
+/* ==========================================================================
+ * WORKPOOL.C — Work-Stealing Thread Pool for the DFS Fan-Outs (-mp, -d, -c)
+ * ==========================================================================
+ *
+ * The OpenMP fan-outs hand out fixed prefixes, so the run time of a single
+ * L is that of the slowest prefix subtree, and stopping the other threads
+ * after a hit needed task cancellation (OMP_CANCELLATION=TRUE). This pool
+ * replaces both:
+ *
+ *   Roots:    the caller describes the initial tasks through a callback;
+ *             workers claim them in order from one shared counter, so the
+ *             caller's ordering (e.g. LUT hint first) is kept.
+ *
+ *   Deques:   every worker owns a small deque of dfs_task_t. The owner pops
+ *             from the tail, thieves take from the head.
+ *
+ *   Splits:   when no root is left and every deque is empty, an idle worker
+ *             raises the want_split flag of a busy one. The busy worker runs
+ *             its engine in slices of WP_SLICE nodes; between slices it
+ *             answers the flag with dfs_stack_split(): the upper half of the
+ *             untried candidates of its shallowest open frame goes into its
+ *             own deque as a compact prefix task. The thief steals it and
+ *             rebuilds the bitset with dfs_stack_init_task(). Only the owner
+ *             ever touches its stack, so no engine state is shared.
+ *
+ *   Stop:     the first ruler sets a shared flag that every worker polls
+ *             between slices; no cancellation support is needed. Another
+ *             thread can abandon the whole search the same way through
+ *             g_wp_cancel (distributed worker, distrib.c).
+ *
+ *   Roots done: each root counts its outstanding parts (itself plus every
+ *             split taken from it). When the count drops to zero the root's
+ *             whole subtree is searched and on_done (checkpointing) fires.
+ *
+ * Lane (wp_solve_lane): a few roots may be named as the lane, e.g. the
+ *             prefixes of the LUT (second, third) pair. They are claimed
+ *             before everything else, and their queued splits are stolen
+ *             first. A worker about to start anything outside the lane
+ *             first asks a busy lane worker with an empty deque to split,
+ *             so the lane subtree keeps spreading over every worker that
+ *             comes free, while the other roots start right behind it.
+ *
+ * Snapshots (wp_solve_cp, checkpointing): every cp->interval seconds
+ *             worker 0 raises `pause`; the others park at their next safe
+ *             point (between slices or while idle), where no task is in
+ *             transit between deques and stacks. With everyone parked,
+ *             each running stack is converted into its remaining tasks
+ *             (dfs_stack_remaining) and, together with the queued tasks
+ *             and the resumed parts not claimed yet, handed to cp->save
+ *             as the unfinished parts of the roots in flight. The pause
+ *             lasts about one slice plus the copy. A resumed run is given
+ *             these parts back; they are searched before the roots, and
+ *             their roots are not started again.
+ *
+ * Window (wp_solve_window): the roots of several L values run in one pool,
+ *             those of the smallest L first in the shared counter, so the
+ *             tail of one L is filled with roots of the next. Idle workers
+ *             steal and ask for splits from the smallest L in flight. A
+ *             ruler at L cancels every larger L (its parts are dropped at
+ *             the next slice); the smaller ones still run to the end, so
+ *             the pool returns the shortest ruler of the window.
+ *
+ * Session: the worker threads, the worker array and the per-root scratch
+ *             arrays outlive a run. Between runs the threads sleep on a
+ *             condition variable; the next run (the next L of the sweep, or
+ *             the next lease of a distributed worker) only resets them, so
+ *             the many short infeasible L at small n no longer pay for
+ *             thread creation and allocation each time.
+ *
+ * Progress: workers add the nodes of every engine slice to g_nodes_done;
+ * with -vt the roots are estimated up front (estimate.c) for the ETA.
+ *
+ * Termination: `pending` counts tasks that exist (queued or running). It is
+ * raised before a root is claimed or a split is queued, so it cannot touch
+ * zero while work remains; no root left and pending == 0 means done.
+ * ========================================================================== */
+
+#define _POSIX_C_SOURCE 200809L
+#include "golomb.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define WP_SLICE     (1LL << 14)  /* nodes between polls (~0.1-0.5 ms) */
+#define WP_MIN_REST  4            /* never split off fewer marks than this */
+#define WP_DEQUE_CAP 64           /* owner splits only into an empty deque */
+#define WP_MAX_THREADS 256
+
+int g_wp_cancel = 0;
+
+typedef struct wp_pool wp_pool_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    int head;                     /* next item thieves take */
+    int tail;                     /* one past the owner's end */
+    int busy;                     /* running a task (split candidate); 2: a
+                                     part of a lane root */
+    int want_split;               /* raised by idle workers */
+    const dfs_stack_t *run_st;    /* running part (read while parked) */
+    long long run_root;
+    int run_slot;                 /* window slot of the running part */
+    wp_pool_t *pool;
+    int id;
+    wp_part_t items[WP_DEQUE_CAP];
+} __attribute__((aligned(64))) wp_worker_t;
+
+struct wp_pool {
+    int n;
+    int target_len;
+    long long nroots;
+    long long next_root;          /* shared root counter */
+    long long pending;            /* tasks queued or running */
+    int *root_open;               /* outstanding parts per root */
+    int stop;                     /* set by the first ruler */
+    int nthreads;
+    wp_root_fn root_fn;
+    wp_root_done_fn on_done;
+    void *ctx;
+    const long long *lane;        /* roots claimed first (NULL: none) */
+    long long nlane;
+    long long next_lane;          /* shared counter over lane */
+    unsigned char *in_lane;       /* per root: listed in lane */
+    ruler_t result;
+    wp_worker_t *workers;
+    /* Snapshots and resume (wp_solve_cp). */
+    const wp_cp_t *cp;            /* NULL: none */
+    long long next_part;          /* shared counter over cp->parts */
+    unsigned char *resumed;       /* roots covered by cp->parts */
+    int pause;                    /* snapshot pending: park */
+    int parked;
+    int active;                   /* worker threads running (incl. 0) */
+    pthread_mutex_t park_lock;
+    pthread_cond_t park_cv;
+    struct timespec last_save;
+    /* Speculative L window (wp_solve_window). */
+    int nlens;                    /* L values in flight (1: target_len) */
+    const int *lens;
+    const long long *first;       /* roots of lens[s]: first[s]..first[s+1]-1 */
+    int found_slot;               /* smallest slot with a ruler; nlens: none */
+    pthread_mutex_t result_lock;
+};
+
+/* Threads and buffers kept across runs (see header comment). Runs are
+ * serialised by run_lock; gen counts them. */
+static struct {
+    pthread_mutex_t run_lock;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;          /* gen advanced */
+    pthread_cond_t idle;          /* running dropped to 0 */
+    long long gen;
+    wp_pool_t *pool;              /* current run */
+    int running;                  /* session threads still in the run */
+    int spawned;                  /* threads 1..spawned exist */
+    wp_worker_t *workers;
+    int nworkers;
+    int *root_open;
+    unsigned char *in_lane, *resumed;
+    size_t root_cap;              /* roots the three arrays can hold */
+} g_session = {
+    .run_lock = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER,
+};
+
+/* ---------------------------------------------------------------------------
+ * wp_num_threads -- Worker count: honours -T (omp_set_num_threads) when
+ * built with OpenMP, otherwise the number of online cores.
+ * --------------------------------------------------------------------------- */
+int wp_num_threads(void)
+{
+#ifdef _OPENMP
+    int t = omp_get_max_threads();
+#else
+    long c = sysconf(_SC_NPROCESSORS_ONLN);
+    int t = (c > 0) ? (int)c : 1;
+#endif
+    if (t < 1) t = 1;
+    if (t > WP_MAX_THREADS) t = WP_MAX_THREADS;
+    return t;
+}
+
+/* ==================== Deque ==================== */
+
+static bool wp_push(wp_worker_t *w, const wp_part_t *it)
+{
+    bool ok = false;
+    pthread_mutex_lock(&w->lock);
+    if (w->tail - w->head < WP_DEQUE_CAP)
+    {
+        w->items[w->tail % WP_DEQUE_CAP] = *it;
+        ++w->tail;
+        ok = true;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return ok;
+}
+
+static bool wp_pop(wp_worker_t *w, wp_part_t *it)
+{
+    bool ok = false;
+    pthread_mutex_lock(&w->lock);
+    if (w->tail > w->head)
+    {
+        --w->tail;
+        *it = w->items[w->tail % WP_DEQUE_CAP];
+        ok = true;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return ok;
+}
+
+static bool wp_steal(wp_worker_t *w, wp_part_t *it)
+{
+    bool ok = false;
+    if (__atomic_load_n(&w->tail, __ATOMIC_RELAXED) == __atomic_load_n(&w->head, __ATOMIC_RELAXED))
+        return false;
+    pthread_mutex_lock(&w->lock);
+    if (w->tail > w->head)
+    {
+        *it = w->items[w->head % WP_DEQUE_CAP];
+        ++w->head;
+        ok = true;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return ok;
+}
+
+/* Steals the head item only if it belongs to a lane root. */
+static bool wp_steal_lane(wp_worker_t *w, const unsigned char *in_lane, wp_part_t *it)
+{
+    bool ok = false;
+    if (__atomic_load_n(&w->tail, __ATOMIC_RELAXED) == __atomic_load_n(&w->head, __ATOMIC_RELAXED))
+        return false;
+    pthread_mutex_lock(&w->lock);
+    if (w->tail > w->head && in_lane[w->items[w->head % WP_DEQUE_CAP].root])
+    {
+        *it = w->items[w->head % WP_DEQUE_CAP];
+        ++w->head;
+        ok = true;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return ok;
+}
+
+static bool wp_deque_empty(wp_worker_t *w)
+{
+    return __atomic_load_n(&w->tail, __ATOMIC_RELAXED) == __atomic_load_n(&w->head, __ATOMIC_RELAXED);
+}
+
+/* ==================== Scheduling ==================== */
+
+/* A ruler was found or the search was cancelled from outside. */
+static inline bool wp_halted(wp_pool_t *p)
+{
+    return __atomic_load_n(&p->stop, __ATOMIC_ACQUIRE) ||
+           __atomic_load_n(&g_wp_cancel, __ATOMIC_ACQUIRE);
+}
+
+/* Window slot of a root (0 outside a window). */
+static inline int wp_slot(const wp_pool_t *p, long long root)
+{
+    int s = 0;
+    while (s + 1 < p->nlens && root >= p->first[s + 1])
+        ++s;
+    return s;
+}
+
+/* Window: the root's L is not below one that already has a ruler. */
+static inline bool wp_moot(wp_pool_t *p, long long root)
+{
+    return p->nlens > 1 &&
+           wp_slot(p, root) >= __atomic_load_n(&p->found_slot, __ATOMIC_ACQUIRE);
+}
+
+/* Marks one part of a root as finished. */
+static void wp_part_done(wp_pool_t *p, long long root)
+{
+    if (__atomic_sub_fetch(&p->root_open[root], 1, __ATOMIC_ACQ_REL) == 0 &&
+        p->on_done && !wp_halted(p))
+        p->on_done(p->ctx, root);
+}
+
+/* Claims root i into it; false if it needs no search (or was resumed). */
+static bool wp_claim_root(wp_pool_t *p, long long i, wp_part_t *it)
+{
+    if (p->resumed && p->resumed[i])
+        return false;               /* its parts are handed out separately */
+    if (wp_moot(p, i))
+        return false;
+    it->root = i;
+    if (p->root_fn(p->ctx, i, &it->t))
+    {
+        __atomic_store_n(&p->root_open[i], 1, __ATOMIC_RELEASE);
+        return true;
+    }
+    /* Nothing to search below this root. */
+    if (p->on_done)
+        p->on_done(p->ctx, i);
+    return false;
+}
+
+/* Asks a busy lane worker with an empty deque to split. */
+static void wp_feed_lane(wp_pool_t *p, wp_worker_t *w)
+{
+    for (int k = 1; k < p->nthreads; ++k)
+    {
+        wp_worker_t *v = &p->workers[(w->id + k) % p->nthreads];
+        if (__atomic_load_n(&v->busy, __ATOMIC_RELAXED) == 2 && wp_deque_empty(v))
+        {
+            __atomic_store_n(&v->want_split, 1, __ATOMIC_RELEASE);
+            return;
+        }
+    }
+}
+
+/* Window: steals from the deque whose head has the smallest L, falling
+ * back to any deque if that one was emptied in between. */
+static bool wp_steal_window(wp_pool_t *p, wp_worker_t *w, wp_part_t *it)
+{
+    int best = -1, best_slot = p->nlens;
+    for (int k = 1; k < p->nthreads; ++k)
+    {
+        wp_worker_t *v = &p->workers[(w->id + k) % p->nthreads];
+        if (wp_deque_empty(v))
+            continue;
+        pthread_mutex_lock(&v->lock);
+        int s = (v->tail > v->head) ? wp_slot(p, v->items[v->head % WP_DEQUE_CAP].root) : p->nlens;
+        pthread_mutex_unlock(&v->lock);
+        if (s < best_slot)
+        {
+            best_slot = s;
+            best = v->id;
+        }
+    }
+    if (best >= 0 && wp_steal(&p->workers[best], it))
+        return true;
+    for (int k = 1; k < p->nthreads; ++k)
+        if (wp_steal(&p->workers[(w->id + k) % p->nthreads], it))
+            return true;
+    return false;
+}
+
+/* Own deque first, then the lane (its roots, then its queued splits), then
+ * resumed parts, then the next root, then the other workers' deques. */
+static bool wp_next(wp_pool_t *p, wp_worker_t *w, wp_part_t *it)
+{
+    if (wp_pop(w, it))
+        return true;
+
+    if (p->in_lane)
+    {
+        while (__atomic_load_n(&p->next_lane, __ATOMIC_RELAXED) < p->nlane)
+        {
+            __atomic_add_fetch(&p->pending, 1, __ATOMIC_ACQ_REL);
+            long long k = __atomic_fetch_add(&p->next_lane, 1, __ATOMIC_ACQ_REL);
+            if (k < p->nlane && wp_claim_root(p, p->lane[k], it))
+                return true;
+            __atomic_sub_fetch(&p->pending, 1, __ATOMIC_ACQ_REL);
+            if (wp_halted(p))
+                return false;
+        }
+        for (int k = 1; k < p->nthreads; ++k)
+            if (wp_steal_lane(&p->workers[(w->id + k) % p->nthreads], p->in_lane, it))
+                return true;
+        wp_feed_lane(p, w);
+    }
+
+    while (p->cp && __atomic_load_n(&p->next_part, __ATOMIC_RELAXED) < p->cp->nparts)
+    {
+        __atomic_add_fetch(&p->pending, 1, __ATOMIC_ACQ_REL);
+        long long i = __atomic_fetch_add(&p->next_part, 1, __ATOMIC_ACQ_REL);
+        if (i < p->cp->nparts)
+        {
+            *it = p->cp->parts[i];
+            return true;
+        }
+        __atomic_sub_fetch(&p->pending, 1, __ATOMIC_ACQ_REL);
+    }
+
+    while (__atomic_load_n(&p->next_root, __ATOMIC_RELAXED) < p->nroots)
+    {
+        __atomic_add_fetch(&p->pending, 1, __ATOMIC_ACQ_REL);
+        long long i = __atomic_fetch_add(&p->next_root, 1, __ATOMIC_ACQ_REL);
+        if (i >= p->nroots)
+        {
+            __atomic_sub_fetch(&p->pending, 1, __ATOMIC_ACQ_REL);
+            break;
+        }
+        if (!(p->in_lane && p->in_lane[i]) && wp_claim_root(p, i, it))
+            return true;
+        __atomic_sub_fetch(&p->pending, 1, __ATOMIC_ACQ_REL);
+        if (wp_halted(p))
+            return false;
+    }
+
+    if (p->nlens > 1)
+        return wp_steal_window(p, w, it);
+    for (int k = 1; k < p->nthreads; ++k)
+        if (wp_steal(&p->workers[(w->id + k) % p->nthreads], it))
+            return true;
+    return false;
+}
+
+/* Asks the next busy worker with an empty deque to split its stack; in a
+ * window the one on the smallest L. */
+static void wp_request_split(wp_pool_t *p, wp_worker_t *w)
+{
+    wp_worker_t *pick = NULL;
+    for (int k = 1; k < p->nthreads; ++k)
+    {
+        wp_worker_t *v = &p->workers[(w->id + k) % p->nthreads];
+        if (__atomic_load_n(&v->busy, __ATOMIC_RELAXED) && wp_deque_empty(v) &&
+            (!pick || __atomic_load_n(&v->run_slot, __ATOMIC_RELAXED) <
+                      __atomic_load_n(&pick->run_slot, __ATOMIC_RELAXED)))
+        {
+            pick = v;
+            if (p->nlens == 1)
+                break;
+        }
+    }
+    if (pick)
+        __atomic_store_n(&pick->want_split, 1, __ATOMIC_RELEASE);
+}
+
+/* Records the ruler in st->pos unless another worker was first (in a
+ * window: unless a shorter one is known; the shortest L stops the pool). */
+static void wp_offer(wp_pool_t *p, const dfs_stack_t *st, long long root)
+{
+    if (p->nlens > 1)
+    {
+        int s = wp_slot(p, root);
+        pthread_mutex_lock(&p->result_lock);
+        if (s < p->found_slot)
+        {
+            p->result.marks = p->n;
+            p->result.length = st->pos[p->n - 1];
+            memcpy(p->result.pos, st->pos, (size_t)p->n * sizeof(int));
+            __atomic_store_n(&p->found_slot, s, __ATOMIC_RELEASE);
+            if (s == 0)
+                __atomic_store_n(&p->stop, 1, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&p->result_lock);
+        return;
+    }
+    int expected = 0;
+    if (__atomic_compare_exchange_n(&p->stop, &expected, 1, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        p->result.marks = p->n;
+        p->result.length = st->pos[p->n - 1];
+        memcpy(p->result.pos, st->pos, (size_t)p->n * sizeof(int));
+    }
+}
+
+/* Worker 0 with everyone else parked: collect the remaining tasks of every
+ * running stack and every deque, and the resumed parts not claimed yet.
+ * Returns the count, or -1 if out of memory. */
+static long long wp_collect(wp_pool_t *p, wp_part_t **out)
+{
+    long long cap = 0;
+    for (int k = 0; k < p->nthreads; ++k)
+        cap += 2 * p->n + (p->workers[k].tail - p->workers[k].head);
+    long long unclaimed = p->cp->nparts - __atomic_load_n(&p->next_part, __ATOMIC_ACQUIRE);
+    if (unclaimed > 0)
+        cap += unclaimed;
+    wp_part_t *parts = (wp_part_t*)malloc((size_t)(cap > 0 ? cap : 1) * sizeof(wp_part_t));
+    if (!parts)
+        return -1;
+    long long count = 0;
+    for (int k = 0; k < p->nthreads; ++k)
+    {
+        wp_worker_t *v = &p->workers[k];
+        if (v->run_st)
+        {
+            dfs_task_t t[DFS_MAX_REMAINING];
+            int m = dfs_stack_remaining(v->run_st, t);
+            for (int j = 0; j < m; ++j)
+            {
+                parts[count].root = v->run_root;
+                parts[count++].t = t[j];
+            }
+        }
+        for (int h = v->head; h < v->tail; ++h)
+            parts[count++] = v->items[h % WP_DEQUE_CAP];
+    }
+    /* Resumed parts nobody has claimed yet. */
+    for (long long i = p->cp->nparts - (unclaimed > 0 ? unclaimed : 0); i < p->cp->nparts; ++i)
+        parts[count++] = p->cp->parts[i];
+    *out = parts;
+    return count;
+}
+
+/* Worker 0: pause the pool, take the snapshot, resume, then save it. */
+static void wp_snapshot(wp_pool_t *p)
+{
+    pthread_mutex_lock(&p->park_lock);
+    __atomic_store_n(&p->pause, 1, __ATOMIC_RELEASE);
+    while (p->parked < p->active - 1)
+        pthread_cond_wait(&p->park_cv, &p->park_lock);
+    wp_part_t *parts = NULL;
+    long long count = wp_collect(p, &parts);
+    __atomic_store_n(&p->pause, 0, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&p->park_cv);
+    pthread_mutex_unlock(&p->park_lock);
+    if (count >= 0 && !wp_halted(p))
+        p->cp->save(p->cp->save_ctx, parts, count);
+    free(parts);
+}
+
+/* ---------------------------------------------------------------------------
+ * wp_safe_point -- Called between slices (st = running stack) and while
+ * idle (st = NULL). Worker 0 takes a snapshot when one is due; the others
+ * park while one is being taken.
+ * --------------------------------------------------------------------------- */
+static void wp_safe_point(wp_pool_t *p, wp_worker_t *w, const dfs_stack_t *st, long long root)
+{
+    if (!p->cp || !p->cp->save)
+        return;
+    if (w->id == 0)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec - p->last_save.tv_sec < p->cp->interval || wp_halted(p))
+            return;
+        w->run_st = st;
+        w->run_root = root;
+        wp_snapshot(p);
+        p->last_save = now;
+        return;
+    }
+    if (!__atomic_load_n(&p->pause, __ATOMIC_ACQUIRE))
+        return;
+    pthread_mutex_lock(&p->park_lock);
+    w->run_st = st;
+    w->run_root = root;
+    ++p->parked;
+    pthread_cond_broadcast(&p->park_cv);
+    while (p->pause)
+        pthread_cond_wait(&p->park_cv, &p->park_lock);
+    --p->parked;
+    pthread_mutex_unlock(&p->park_lock);
+}
+
+/* Runs one task in slices, answering split requests in between. */
+static void wp_run(wp_pool_t *p, wp_worker_t *w, dfs_stack_t *st, const wp_part_t *it)
+{
+    int slot = wp_slot(p, it->root);
+    if (wp_moot(p, it->root) || !dfs_stack_init_task(st, p->n, p->lens[slot], &it->t))
+        return;
+    __atomic_store_n(&w->run_slot, slot, __ATOMIC_RELAXED);
+    __atomic_store_n(&w->busy, (p->in_lane && p->in_lane[it->root]) ? 2 : 1, __ATOMIC_RELEASE);
+    for (;;)
+    {
+        wp_safe_point(p, w, st, it->root);
+        int r = dfs_stack_run(st, WP_SLICE);
+        __atomic_add_fetch(&g_nodes_done, (unsigned long long)st->nodes, __ATOMIC_RELAXED);
+        st->nodes = 0;
+        if (r == DFS_FOUND)
+        {
+            wp_offer(p, st, it->root);
+            break;
+        }
+        if (r == DFS_EXHAUSTED || wp_halted(p) || wp_moot(p, it->root))
+            break;
+        if (__atomic_load_n(&w->want_split, __ATOMIC_ACQUIRE))
+        {
+            __atomic_store_n(&w->want_split, 0, __ATOMIC_RELAXED);
+            wp_part_t part;
+            part.root = it->root;
+            if (wp_deque_empty(w) && dfs_stack_split(st, &part.t, WP_MIN_REST))
+            {
+                /* Counted before it becomes visible to thieves. */
+                __atomic_add_fetch(&p->root_open[it->root], 1, __ATOMIC_ACQ_REL);
+                __atomic_add_fetch(&p->pending, 1, __ATOMIC_ACQ_REL);
+                if (!wp_push(w, &part))
+                {
+                    /* Cannot happen with an empty deque; keep it safe. */
+                    __atomic_sub_fetch(&p->root_open[it->root], 1, __ATOMIC_ACQ_REL);
+                    __atomic_sub_fetch(&p->pending, 1, __ATOMIC_ACQ_REL);
+                    dfs_frame_t *f = &st->frame[part.t.depth];
+                    if (part.t.hi < f->next)
+                        f->wrap_hi = part.t.hi;     /* hint order: below the hint */
+                    else
+                        f->max_next = part.t.hi;
+                }
+            }
+        }
+    }
+    __atomic_store_n(&w->busy, 0, __ATOMIC_RELEASE);
+}
+
+static void *wp_worker_main(void *arg)
+{
+    static __thread dfs_stack_t st;
+    wp_worker_t *w = (wp_worker_t*)arg;
+    wp_pool_t *p = w->pool;
+    const struct timespec nap = { 0, 50 * 1000 };  /* 50 us while idle */
+
+    while (!wp_halted(p))
+    {
+        wp_safe_point(p, w, NULL, -1);
+        wp_part_t it;
+        if (wp_next(p, w, &it))
+        {
+            wp_run(p, w, &st, &it);
+            wp_part_done(p, it.root);
+            __atomic_sub_fetch(&p->pending, 1, __ATOMIC_ACQ_REL);
+            continue;
+        }
+        if (__atomic_load_n(&p->next_root, __ATOMIC_ACQUIRE) >= p->nroots &&
+            __atomic_load_n(&p->pending, __ATOMIC_ACQUIRE) == 0)
+            break;
+        wp_request_split(p, w);
+        nanosleep(&nap, NULL);
+    }
+    if (w->id != 0)
+    {
+        /* A snapshot must no longer wait for us (nor read our stack). */
+        pthread_mutex_lock(&p->park_lock);
+        w->run_st = NULL;
+        --p->active;
+        pthread_cond_broadcast(&p->park_cv);
+        pthread_mutex_unlock(&p->park_lock);
+    }
+    return NULL;
+}
+
+/* A session thread: joins every run whose pool has a worker `id`. */
+static void *wp_session_main(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+    long long seen = 0;
+    pthread_mutex_lock(&g_session.lock);
+    for (;;)
+    {
+        while (g_session.gen == seen)
+            pthread_cond_wait(&g_session.wake, &g_session.lock);
+        seen = g_session.gen;
+        wp_pool_t *p = g_session.pool;
+        if (id >= p->nthreads)
+            continue;
+        pthread_mutex_unlock(&g_session.lock);
+        wp_worker_main(&p->workers[id]);
+        pthread_mutex_lock(&g_session.lock);
+        if (--g_session.running == 0)
+            pthread_cond_broadcast(&g_session.idle);
+    }
+    return NULL;
+}
+
+/* Worker array and root arrays for a run of nthreads over nroots roots,
+ * cleared; false if out of memory. Called with run_lock held. */
+static bool wp_session_buffers(int nthreads, long long nroots)
+{
+    if (g_session.nworkers < nthreads)
+    {
+        wp_worker_t *w = NULL;
+        if (posix_memalign((void**)&w, 64, (size_t)nthreads * sizeof(wp_worker_t)) != 0)
+            return false;
+        for (int i = 0; i < g_session.nworkers; ++i)
+            pthread_mutex_destroy(&g_session.workers[i].lock);
+        free(g_session.workers);
+        for (int i = 0; i < nthreads; ++i)
+            pthread_mutex_init(&w[i].lock, NULL);
+        g_session.workers = w;
+        g_session.nworkers = nthreads;
+    }
+    for (int i = 0; i < nthreads; ++i)
+    {
+        wp_worker_t *w = &g_session.workers[i];
+        w->head = w->tail = 0;
+        w->busy = w->want_split = 0;
+        w->run_st = NULL;
+        w->run_root = -1;
+        w->run_slot = 0;
+        w->id = i;
+    }
+    if (g_session.root_cap < (size_t)nroots)
+    {
+        int *ro = (int*)realloc(g_session.root_open, (size_t)nroots * sizeof(int));
+        if (ro)
+            g_session.root_open = ro;
+        unsigned char *il = (unsigned char*)realloc(g_session.in_lane, (size_t)nroots);
+        if (il)
+            g_session.in_lane = il;
+        unsigned char *rs = (unsigned char*)realloc(g_session.resumed, (size_t)nroots);
+        if (rs)
+            g_session.resumed = rs;
+        if (!ro || !il || !rs)
+            return false;
+        g_session.root_cap = (size_t)nroots;
+    }
+    memset(g_session.root_open, 0, (size_t)nroots * sizeof(int));
+    return true;
+}
+
+/* Starts session threads up to worker id nthreads-1; returns how many of
+ * them exist. Called with run_lock held. */
+static int wp_session_spawn(int nthreads)
+{
+    while (g_session.spawned < nthreads - 1)
+    {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, wp_session_main,
+                           (void*)(intptr_t)(g_session.spawned + 1)) != 0)
+            break;
+        pthread_detach(tid);
+        ++g_session.spawned;
+    }
+    return (g_session.spawned < nthreads - 1) ? g_session.spawned : nthreads - 1;
+}
+
+/* ---------------------------------------------------------------------------
+ * wp_solve_pool -- Run the pool over roots 0..nroots-1 (see header comment),
+ * the `nlane` roots listed in `lane` first and ahead of everything else
+ * (lane may be NULL), starting with the resumed parts of cp and taking
+ * snapshots for cp->save (cp may be NULL). With nlens > 1 the roots are
+ * those of a window of L values (lens, first); else all are target_len.
+ * The calling thread works as worker 0.
+ * --------------------------------------------------------------------------- */
+static bool wp_solve_pool(int n, int target_len, long long nroots, wp_root_fn root,
+                          wp_root_done_fn on_done, void *ctx, const wp_cp_t *cp,
+                          const long long *lane, long long nlane,
+                          int nlens, const int *lens, const long long *first, ruler_t *out)
+{
+    if (nroots <= 0)
+        return false;
+    pthread_mutex_lock(&g_session.run_lock);
+    wp_pool_t p;
+    memset(&p, 0, sizeof p);
+    p.n = n;
+    p.target_len = target_len;
+    p.nlens = (nlens > 1) ? nlens : 1;
+    p.lens = (nlens > 1) ? lens : &p.target_len;
+    p.first = first;
+    p.found_slot = p.nlens;
+    p.nroots = nroots;
+    p.root_fn = root;
+    p.on_done = on_done;
+    p.ctx = ctx;
+    p.nthreads = wp_num_threads();
+    if (!wp_session_buffers(p.nthreads, nroots))
+    {
+        pthread_mutex_unlock(&g_session.run_lock);
+        return false;
+    }
+    p.root_open = g_session.root_open;
+    p.workers = g_session.workers;
+
+    if (lane && nlane > 0)
+    {
+        p.in_lane = g_session.in_lane;
+        memset(p.in_lane, 0, (size_t)nroots);
+        p.lane = lane;
+        p.nlane = nlane;
+        for (long long k = 0; k < nlane; ++k)
+            p.in_lane[lane[k]] = 1;
+    }
+
+    /* Resumed parts: their roots count them as outstanding and are skipped
+     * when the root counter passes them. */
+    p.cp = cp;
+    if (cp && cp->nparts > 0)
+    {
+        p.resumed = g_session.resumed;
+        memset(p.resumed, 0, (size_t)nroots);
+        for (long long k = 0; k < cp->nparts; ++k)
+        {
+            p.resumed[cp->parts[k].root] = 1;
+            ++p.root_open[cp->parts[k].root];
+        }
+    }
+    pthread_mutex_init(&p.park_lock, NULL);
+    pthread_cond_init(&p.park_cv, NULL);
+    pthread_mutex_init(&p.result_lock, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &p.last_save);
+
+    /* Progress for the heartbeat; callers that already estimated the
+     * roots (e.g. for ordering) set g_est_nodes themselves. A window has
+     * no single L to estimate. */
+    __atomic_store_n(&g_nodes_done, 0, __ATOMIC_RELAXED);
+    if (g_estimate && g_est_nodes <= 0.0 && p.nlens == 1)
+        g_est_nodes = estimate_roots(n, target_len, nroots, root, ctx, NULL);
+
+    for (int i = 0; i < p.nthreads; ++i)
+        p.workers[i].pool = &p;
+    /* Workers that failed to start simply never run: splits only go to a
+     * worker's own deque, which the owner drains itself. */
+    int started = wp_session_spawn(p.nthreads);
+    p.active = 1 + started;
+    pthread_mutex_lock(&g_session.lock);
+    g_session.pool = &p;
+    g_session.running = started;
+    ++g_session.gen;
+    pthread_cond_broadcast(&g_session.wake);
+    pthread_mutex_unlock(&g_session.lock);
+    wp_worker_main(&p.workers[0]);
+    pthread_mutex_lock(&g_session.lock);
+    while (g_session.running > 0)
+        pthread_cond_wait(&g_session.idle, &g_session.lock);
+    g_session.pool = NULL;
+    pthread_mutex_unlock(&g_session.lock);
+
+    pthread_cond_destroy(&p.park_cv);
+    pthread_mutex_destroy(&p.park_lock);
+    pthread_mutex_destroy(&p.result_lock);
+    pthread_mutex_unlock(&g_session.run_lock);
+    g_est_nodes = 0.0;
+
+    /* A cancelled window may not have finished the L below its ruler. */
+    if (p.nlens == 1 ? !p.stop
+                     : (p.found_slot == p.nlens || __atomic_load_n(&g_wp_cancel, __ATOMIC_ACQUIRE)))
+        return false;
+    *out = p.result;
+    return true;
+}
+
+bool wp_solve_lane(int n, int target_len, long long nroots, wp_root_fn root,
+                   wp_root_done_fn on_done, void *ctx, const wp_cp_t *cp,
+                   const long long *lane, long long nlane, ruler_t *out)
+{
+    return wp_solve_pool(n, target_len, nroots, root, on_done, ctx, cp, lane, nlane,
+                         1, NULL, NULL, out);
+}
+
+bool wp_solve_window(int n, int nlens, const int *lens, const long long *first,
+                     wp_root_fn root, void *ctx, const long long *lane, long long nlane,
+                     ruler_t *out)
+{
+    return wp_solve_pool(n, lens[nlens - 1], first[nlens], root, NULL, ctx, NULL, lane, nlane,
+                         nlens, lens, first, out);
+}
+
+bool wp_solve_cp(int n, int target_len, long long nroots, wp_root_fn root,
+                 wp_root_done_fn on_done, void *ctx, const wp_cp_t *cp, ruler_t *out)
+{
+    return wp_solve_lane(n, target_len, nroots, root, on_done, ctx, cp, NULL, 0, out);
+}
+
+bool wp_solve(int n, int target_len, long long nroots, wp_root_fn root,
+              wp_root_done_fn on_done, void *ctx, ruler_t *out)
+{
+    return wp_solve_cp(n, target_len, nroots, root, on_done, ctx, NULL, out);
+}
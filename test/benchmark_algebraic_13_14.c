@@ -6,9 +6,6 @@
 #include <sys/stat.h>
 #include <time.h>
 
-const char *g_cp_path = NULL;
-int g_cp_interval_sec = 60;
-
 static double now_ms(void) {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -7,9 +7,6 @@
 #include <sys/stat.h>
 #include <time.h>
 
-const char *g_cp_path = NULL;
-int g_cp_interval_sec = 60;
-
 #define FIRST_N 13
 #define LAST_N 14
 #define NEW_RUNS 8
@@ -10,9 +10,6 @@
 #include <time.h>
 #include <unistd.h>
 
-const char *g_cp_path = NULL;
-int g_cp_interval_sec = 60;
-
 #define FIRST_N 9
 #define LAST_N 12
 #define RUNS_PER_SOLVER 8
@@ -7,10 +7,6 @@
 #include <time.h>
 #include <sys/stat.h>
 
-/* Für solver.c benötigte externe Variablen */
-const char *g_cp_path = NULL;
-int g_cp_interval_sec = 60;
-
 /* Externe Solver-Funktionen */
 extern bool solve_golomb_physics(int n, int target_length, ruler_t *out, bool verbose);
 extern bool solve_golomb_evolutionary(int n, int target_length, ruler_t *out, bool verbose);
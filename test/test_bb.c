@@ -0,0 +1,64 @@
+#define _POSIX_C_SOURCE 200809L
+#include "golomb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Branch-and-Bound (-bb), mit und ohne Hint-Reihenfolge (-ho), seriell und
+ * parallel: das Ergebnis muss ein gültiges Lineal mit der optimalen Länge
+ * aus der LUT sein. Mit -ho ist das LUT-Lineal der erste Kandidat, danach
+ * muss jede Verbesserung auch den noch offenen Bereich unter dem Hint
+ * beschneiden. */
+
+#define N_MIN 4
+#define N_MAX 11
+
+/* n Marken ab 0, streng steigend, keine doppelten Abstände */
+static bool ruler_ok(const ruler_t *r, int n) {
+    if (r->marks != n || r->pos[0] != 0 || r->pos[n - 1] != r->length) return false;
+    bool seen[MAX_LEN_BITSET + 1] = {false};
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++) {
+            int d = r->pos[j] - r->pos[i];
+            if (d <= 0 || d > MAX_LEN_BITSET || seen[d]) return false;
+            seen[d] = true;
+        }
+    return true;
+}
+
+int main(void) {
+    int failures = 0;
+    static const char *const mode[4] = { "seriell", "parallel", "-ho seriell", "-ho parallel" };
+
+    printf("=================================================================\n");
+    printf("Test des Branch-and-Bound-Modus (solve_golomb_bb)\n");
+    printf("=================================================================\n\n");
+    printf("n  | Optimal | seriell | parallel | -ho seriell | -ho parallel\n");
+    printf("---|---------|---------|----------|-------------|-------------\n");
+
+    for (int n = N_MIN; n <= N_MAX; n++) {
+        const ruler_t *ref = lut_lookup_by_marks(n);
+        if (!ref) continue;
+        int got[4];
+        for (int m = 0; m < 4; m++) {
+            ruler_t out;
+            memset(&out, 0, sizeof out);
+            g_hint_order = m >= 2;
+            bool found = solve_golomb_bb(n, MAX_LEN_BITSET + 1, &out, false, m & 1);
+            got[m] = found && ruler_ok(&out, n) ? out.length : -1;
+            if (got[m] != ref->length) {
+                printf("  [FAIL] n=%d %s\n", n, mode[m]);
+                failures++;
+            }
+        }
+        printf("%2d | %7d | %7d | %8d | %11d | %12d\n",
+               n, ref->length, got[0], got[1], got[2], got[3]);
+    }
+    g_hint_order = false;
+
+    printf("\n=================================================================\n");
+    printf("GESAMTERGEBNIS: %s\n", failures ? "FEHLER" : "ALLE TESTS BESTANDEN");
+    printf("=================================================================\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+#define _POSIX_C_SOURCE 200809L
+#include "golomb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+/* Round-Trip einer GRCP-Datei: Bitset und Teilaufgaben müssen ein
+ * cp_close/cp_open überstehen, Teile erledigter Wurzeln fallen weg, und
+ * eine v4-Datei mit falschem parts_sum verliert nur ihre Teile. Eine
+ * v1-Datei (Paare (second, third)) wird auf die Präfix-Wurzeln übertragen,
+ * eine unpassende v1-Datei bleibt unverändert. */
+
+#define TOTAL 100
+#define HDR_PARTS_SUM 52   /* Offset von parts_sum im 64-Byte-Header */
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("  [%s] %s\n", ok ? "OK" : "FAIL", what);
+    if (!ok) failures++;
+}
+
+static wp_part_t make_part(long long root, int depth, int lo, int hi) {
+    wp_part_t p;
+    memset(&p, 0, sizeof p);
+    p.root = root;
+    p.t.depth = depth;
+    p.t.lo = lo;
+    p.t.hi = hi;
+    for (int j = 0; j < depth; j++)
+        p.t.pos[j] = j * (j + 1) / 2;   /* 0, 1, 3, 6, ... */
+    return p;
+}
+
+static bool parts_equal(const wp_part_t *a, const wp_part_t *b) {
+    if (a->root != b->root || a->t.depth != b->t.depth ||
+        a->t.lo != b->t.lo || a->t.hi != b->t.hi)
+        return false;
+    for (int j = 0; j < a->t.depth; j++)
+        if (a->t.pos[j] != b->t.pos[j]) return false;
+    return true;
+}
+
+/* v1-Datei schreiben: 40-Byte-Header, dann das Bitset über `total` Paare */
+static bool write_v1(const char *path, int n, int L, uint64_t total,
+                     int hs, int ht, const long long *done, int ndone) {
+    unsigned char hdr[40];
+    uint32_t u[3] = { 1, (uint32_t)n, (uint32_t)L };
+    uint32_t hint[4] = { (uint32_t)hs, (uint32_t)ht, 1, 0 };
+    memcpy(hdr, "GRCP", 4);
+    memcpy(hdr + 4, u, sizeof u);
+    memcpy(hdr + 16, &total, sizeof total);
+    memcpy(hdr + 24, hint, sizeof hint);
+    size_t words = (size_t)((total + 31) / 32);
+    uint32_t *bits = calloc(words, sizeof(uint32_t));
+    if (!bits) return false;
+    for (int k = 0; k < ndone; k++)
+        bits[done[k] >> 5] |= 1u << (done[k] & 31);
+    FILE *fp = fopen(path, "wb");
+    bool ok = fp && fwrite(hdr, 1, sizeof hdr, fp) == sizeof hdr &&
+              fwrite(bits, sizeof(uint32_t), words, fp) == words;
+    if (fp && fclose(fp) != 0) ok = false;
+    free(bits);
+    return ok;
+}
+
+/* Dateiinhalt lesen (für den Vergleich vorher/nachher) */
+static long read_file(const char *path, unsigned char *buf, long cap) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+    long len = (long)fread(buf, 1, (size_t)cap, fp);
+    fclose(fp);
+    return len;
+}
+
+/* Synthetische Präfix-Wurzeln: (second, third) je Wurzel */
+static const int v1_roots[][2] = { {1, 6}, {2, 9}, {1, 7}, {1, 6}, {3, 8}, {1, 5} };
+#define V1_NROOTS ((long long)(sizeof v1_roots / sizeof v1_roots[0]))
+
+static void v1_pair(const void *ctx, long long i, int *second, int *third) {
+    (void)ctx;
+    *second = v1_roots[i][0];
+    *third = v1_roots[i][1];
+}
+
+/* Einen Byte der Datei an `offset` invertieren */
+static bool flip_byte(const char *path, long offset) {
+    FILE *fp = fopen(path, "r+b");
+    if (!fp) return false;
+    int c = -1;
+    if (fseek(fp, offset, SEEK_SET) == 0) c = fgetc(fp);
+    bool ok = c != EOF && fseek(fp, offset, SEEK_SET) == 0 && fputc(c ^ 0xff, fp) != EOF;
+    return fclose(fp) == 0 && ok;
+}
+
+int main(void) {
+    char path[64];
+    snprintf(path, sizeof path, "/tmp/test_checkpoint_%ld.grcp", (long)getpid());
+    remove(path);
+    g_cp_interval_sec = 3600;           /* nur cp_save_parts/cp_close schreiben */
+
+    cp_key_t key = { 10, 55, CP_ROOTS_PREFIX, 0, 0, 0 };
+    const long long done[] = { 3, 40, 99 };
+    wp_part_t parts[3] = {
+        make_part(5, 2, 3, 20),
+        make_part(40, 3, 7, 30),        /* Wurzel erledigt: fällt weg */
+        make_part(77, 4, 11, 40),
+    };
+
+    printf("=================================================================\n");
+    printf("Test der Checkpoint-Dateien (GRCP)\n");
+    printf("=================================================================\n\n");
+
+    /* Schreiben */
+    cp_state_t *cp = cp_open(path, &key, TOTAL);
+    check(cp && cp_active(cp), "cp_open legt die Datei an");
+    if (!cp) return 1;
+    for (int k = 0; k < 3; k++)
+        cp_mark_done(cp, done[k]);
+    cp_save_parts(cp, parts, 3);
+    cp_close(cp);
+
+    check(cp_peek_total(path, &key) == TOTAL, "cp_peek_total liefert total");
+    cp_key_t other = key;
+    other.L++;
+    check(cp_peek_total(path, &other) == 0, "anderer Schlüssel passt nicht");
+
+    /* Wieder laden */
+    cp = cp_open(path, &key, TOTAL);
+    check(cp != NULL, "cp_open lädt die Datei");
+    if (!cp) return 1;
+    bool bits_ok = true;
+    for (long long i = 0; i < TOTAL; i++) {
+        bool want = (i == 3 || i == 40 || i == 99);
+        if (cp_is_done(cp, i) != want) bits_ok = false;
+    }
+    check(bits_ok, "Bitset überlebt den Round-Trip");
+    long long n = 0;
+    const wp_part_t *got = cp_resume_parts(cp, &n);
+    check(n == 2 && got && parts_equal(&got[0], &parts[0]) && parts_equal(&got[1], &parts[2]),
+          "Teile überleben, Teil der erledigten Wurzel fällt weg");
+    cp_close(cp);
+
+    /* parts_sum beschädigen */
+    check(flip_byte(path, HDR_PARTS_SUM), "parts_sum in der Datei verändert");
+    cp = cp_open(path, &key, TOTAL);
+    check(cp != NULL, "cp_open lädt die beschädigte Datei");
+    if (!cp) return 1;
+    bits_ok = true;
+    for (long long i = 0; i < TOTAL; i++) {
+        bool want = (i == 3 || i == 40 || i == 99);
+        if (cp_is_done(cp, i) != want) bits_ok = false;
+    }
+    check(bits_ok, "Bitset bleibt bei falschem parts_sum erhalten");
+    n = -1;
+    cp_resume_parts(cp, &n);
+    check(n == 0, "Teile mit falschem parts_sum werden verworfen");
+    cp_close(cp);
+
+    /* Version 1: n=10, L=55 -> T=48, s <= 27, 918 Paare. Mit Hint (1, 6)
+     * ist Paar 0 = (1, 6), dann Abstand 1: (1, 5), (1, 7), (2, 6). */
+    const long long v1_done[] = { 0, 2 };      /* (1, 6), (1, 7) */
+    check(write_v1(path, 10, 55, 918, 1, 6, v1_done, 2), "v1-Datei geschrieben");
+    check(cp_peek_total(path, &key) == 0, "v1-Gesamtzahl legt keine Tiefe fest");
+    cp = cp_open_prefix(path, &key, V1_NROOTS, v1_pair, NULL);
+    check(cp && cp_active(cp), "cp_open_prefix lädt die v1-Datei");
+    if (!cp) return 1;
+    check(cp_is_done(cp, 0) && !cp_is_done(cp, 1) && cp_is_done(cp, 2) &&
+          cp_is_done(cp, 3) && !cp_is_done(cp, 4) && !cp_is_done(cp, 5),
+          "v1-Paare auf die Wurzeln übertragen");
+    cp_close(cp);
+    check(cp_peek_total(path, &key) == V1_NROOTS, "v1-Datei als v4 neu geschrieben");
+
+    /* Version 1 mit falscher Paaranzahl: abgewiesen, Datei unverändert */
+    static unsigned char before[4096], after[4096];
+    check(write_v1(path, 10, 55, 900, 1, 6, v1_done, 2), "v1-Datei mit falscher Anzahl");
+    long len = read_file(path, before, sizeof before);
+    cp = cp_open_prefix(path, &key, V1_NROOTS, v1_pair, NULL);
+    check(cp && !cp_active(cp), "unpassende v1-Datei abgewiesen");
+    if (cp) {
+        cp_mark_done(cp, 1);
+        cp_close(cp);
+    }
+    check(len > 0 && read_file(path, after, sizeof after) == len &&
+          memcmp(before, after, (size_t)len) == 0, "unpassende v1-Datei bleibt unverändert");
+
+    remove(path);
+
+    printf("\n=================================================================\n");
+    printf("GESAMTERGEBNIS: %s\n", failures ? "FEHLER" : "ALLE TESTS BESTANDEN");
+    printf("=================================================================\n");
+    return failures ? 1 : 0;
+}
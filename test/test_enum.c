@@ -0,0 +1,79 @@
+#define _POSIX_C_SOURCE 200809L
+#include "golomb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Enumerations-Modus (-ea): Anzahl aller Lineale mit genau n Marken und
+ * Länge L (Spiegelbilder einmal), seriell und parallel, und die
+ * ausgegebenen Zeilen müssen gültige, kanonische Lineale sein. */
+
+typedef struct {
+    int n;
+    int L;
+    long long expected;
+} enum_case_t;
+
+static const enum_case_t cases[] = {
+    { 6, 17,  4 },
+    { 6, 21, 86 },
+    { 7, 25,  5 },
+    { 7, 27, 20 },
+};
+
+/* Zeilen im Sink prüfen: n Marken, 0 .. L, keine doppelten Abstände,
+ * kleinere erste Lücke als das Spiegelbild. Liefert die Zeilenanzahl
+ * oder -1 bei einer ungültigen Zeile. */
+static long long check_sink(FILE *fp, int n, int L) {
+    long long lines = 0;
+    int pos[MAX_MARKS];
+    rewind(fp);
+    for (;;) {
+        int k = 0;
+        while (k < n && fscanf(fp, "%d", &pos[k]) == 1) k++;
+        if (k == 0) break;
+        if (k != n || pos[0] != 0 || pos[n - 1] != L) return -1;
+        if (pos[1] > L - pos[n - 2]) return -1;
+        bool seen[MAX_LEN_BITSET + 1] = {false};
+        for (int i = 0; i < n; i++)
+            for (int j = i + 1; j < n; j++) {
+                int d = pos[j] - pos[i];
+                if (d <= 0 || d > L || seen[d]) return -1;
+                seen[d] = true;
+            }
+        lines++;
+    }
+    return lines;
+}
+
+int main(void) {
+    int failures = 0;
+
+    printf("=================================================================\n");
+    printf("Test des Enumerations-Modus (enumerate_golomb)\n");
+    printf("=================================================================\n\n");
+    printf("n  |  L  | Erwartet | Seriell  | Parallel | Ausgabe\n");
+    printf("---|-----|----------|----------|----------|--------\n");
+
+    for (size_t c = 0; c < sizeof cases / sizeof cases[0]; c++) {
+        const enum_case_t *tc = &cases[c];
+        long long got[2];
+        bool sink_ok = true;
+        for (int par = 0; par < 2; par++) {
+            FILE *fp = tmpfile();
+            got[par] = enumerate_golomb(tc->n, tc->L, fp, par == 1);
+            if (!fp || check_sink(fp, tc->n, tc->L) != got[par]) sink_ok = false;
+            if (fp) fclose(fp);
+        }
+        bool ok = got[0] == tc->expected && got[1] == tc->expected && sink_ok;
+        printf("%2d | %3d | %8lld | %8lld | %8lld | %s\n", tc->n, tc->L, tc->expected,
+               got[0], got[1], sink_ok ? "OK" : "FEHLER");
+        if (!ok) failures++;
+    }
+
+    printf("\n=================================================================\n");
+    printf("GESAMTERGEBNIS: %s\n", failures ? "FEHLER" : "ALLE TESTS BESTANDEN");
+    printf("=================================================================\n");
+    return failures ? 1 : 0;
+}